@@ -16,6 +16,15 @@ struct Mnemonic {
 };
 
 
+// One step of a constant expression, stored in postfix order. An op of 0
+// pushes the value (or identifier) of the term; any other op is one of the
+// binary operators + - * / % applied to the top two results.
+struct ExprTerm {
+    char op;
+    int value;
+    std::string identifier;
+};
+
 struct Value {
     Value()
     : value(0)
@@ -27,8 +36,13 @@ struct Value {
     : value(0x7FFFFFFF), identifier(identifier)
     { }
 
+    bool isConstant() const {
+        return identifier.empty() && expression.empty();
+    }
+
     int value;
     std::string identifier;
+    std::vector<ExprTerm> expression;
 };
 
 struct AsmLine {
@@ -112,7 +126,7 @@ struct SymbolDef {
 struct Backpatch {
     Origin origin;
     unsigned long pos;
-    std::string name;
+    Value value;
     int width;
 };
 
@@ -193,6 +207,7 @@ struct Program {
     Program();
     ErrorLog errorLog;
     std::vector<AsmLine*> code;
+    std::vector<AsmLine*> stripped;
     std::vector<std::string> exports;
     std::vector<ItemLocation> locations;
     std::vector<NpcType> npcTypes;
@@ -216,11 +231,14 @@ struct Program {
 
 std::ostream& operator<<(std::ostream &out, const Origin &origin);
 std::ostream& operator<<(std::ostream &out, TokenType type);
+std::ostream& operator<<(std::ostream &out, const Value &value);
 void clearTokenDump();
 void dumpCode(const std::vector<AsmLine*> &code);
+void dumpCode(std::ostream &codeDump, const std::vector<AsmLine*> &code);
 void dumpErrors(const Program &program);
 void dumpPatches(const Program &program);
 void dumpStrings(const Program &program);
+void dumpStripped(const Program &program);
 void dumpSymbols(const Program &program);
 void dumpTokens(const std::vector<Token> &tokens);
 
@@ -236,6 +254,11 @@ bool parseFile(const std::string &filename, ErrorLog &errorLog, Program &code);
 
 const Mnemonic& getMnemonic(const std::string &name);
 
+Value makeExpression(ErrorLog &errorLog, const Origin &origin, const Value &lhs, char op, const Value &rhs);
+bool evaluateValue(Program &code, const Origin &origin, const Value &value, int &result, std::string &undefinedName);
+
+void foldConstants(Program &code);
+void stripUnreachable(Program &code);
 void generate(Program &code, const std::string &outputFile);
 
 #endif
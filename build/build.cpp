@@ -9,6 +9,8 @@ bool buildHeader(Program &code);
 
 int main(int argc, char *argv[]) {
     bool doDumpInternals = false;
+    bool doStrip = false;
+    bool doFold = false;
     std::vector<std::string> files;
     std::string outputFile = "output.bin";
     Program code;
@@ -27,6 +29,10 @@ int main(int argc, char *argv[]) {
             if (arg == "-dump") {
                 doDumpInternals = true;
                 code.doTokenDump = true;
+            } else if (arg == "-fold") {
+                doFold = true;
+            } else if (arg == "-strip") {
+                doStrip = true;
             } else if (arg == "-o") {
                 ++i;
                 if (i >= argc) {
@@ -57,12 +63,14 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    if (doFold) foldConstants(code);
     buildHeader(code);
     if (!code.errorLog.errors.empty()) {
         dumpErrors(code);
         return 1;
     }
 
+    if (doStrip) stripUnreachable(code);
     generate(code, outputFile);
     if (!code.errorLog.errors.empty()) {
         dumpErrors(code);
@@ -72,6 +80,7 @@ int main(int argc, char *argv[]) {
     if (doDumpInternals) {
         dumpStrings(code);
         dumpCode(code.code);
+        if (doStrip) dumpStripped(code);
         dumpSymbols(code);
         dumpPatches(code);
     }
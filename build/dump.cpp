@@ -2,6 +2,7 @@
 #include <string>
 #include <fstream>
 #include <iomanip>
+#include <sstream>
 #include "assemble.h"
 
 void dumpString(std::ostream &out, const std::string &text);
@@ -40,6 +41,15 @@ std::ostream& operator<<(std::ostream &out, TokenType type) {
         case TokenType::Equals:
             out << "EQUALS";
             break;
+        case TokenType::OpenParen:
+            out << "OPEN_PAREN";
+            break;
+        case TokenType::CloseParen:
+            out << "CLOSE_PAREN";
+            break;
+        case TokenType::Operator:
+            out << "OPERATOR";
+            break;
         case TokenType::EOL:
             out << "EOL";
             break;
@@ -47,14 +57,46 @@ std::ostream& operator<<(std::ostream &out, TokenType type) {
     return out;
 }
 
+std::ostream& operator<<(std::ostream &out, const Value &value) {
+    if (value.expression.empty()) {
+        if (value.identifier.empty()) out << value.value;
+        else                          out << value.identifier;
+        return out;
+    }
+
+    // rebuild infix form from the postfix terms
+    std::vector<std::string> stack;
+    for (const ExprTerm &term : value.expression) {
+        if (term.op == 0) {
+            if (term.identifier.empty()) stack.push_back(std::to_string(term.value));
+            else                         stack.push_back(term.identifier);
+        } else if (stack.size() >= 2) {
+            std::string rhs = stack.back();
+            stack.pop_back();
+            stack.back() = "(" + stack.back() + " " + term.op + " " + rhs + ")";
+        }
+    }
+    if (!stack.empty()) out << stack.back();
+    return out;
+}
+
 void clearTokenDump() {
     std::ofstream out("_tokens.txt");
 }
 
 void dumpCode(const std::vector<AsmLine*> &code) {
+    std::ofstream codeDump("_code.txt");
+    dumpCode(codeDump, code);
+}
+
+void dumpStripped(const Program &program) {
+    std::ofstream codeDump("_stripped.txt");
+    dumpCode(codeDump, program.stripped);
+}
+
+void dumpCode(std::ostream &codeDump, const std::vector<AsmLine*> &code) {
     static unsigned sizeMasks[5] = { 0, 0xFF, 0xFFFF, 0, 0xFFFFFFFF };
 
-    std::ofstream codeDump("_code.txt");
     for (AsmLine *line : code) {
         AsmData  *data = dynamic_cast<AsmData*>(line);
         AsmLabel *label = dynamic_cast<AsmLabel*>(line);
@@ -103,13 +145,7 @@ void dumpCode(const std::vector<AsmLine*> &code) {
             codeDump << "OPCODE " << asmcode->origin << " " << asmcode->mnemonic.name;
             codeDump << '(' << static_cast<int>(asmcode->mnemonic.opcode) << ')';
             if (asmcode->mnemonic.operandSize != 0) {
-                codeDump << "  <";
-                if (asmcode->operandValue.identifier.empty()) {
-                    codeDump << asmcode->operandValue.value;
-                } else {
-                    codeDump << asmcode->operandValue.identifier;
-                }
-                codeDump << '>';
+                codeDump << "  <" << asmcode->operandValue << '>';
             }
             codeDump << '\n';
         }
@@ -132,7 +168,9 @@ void dumpPatches(const Program &program) {
     std::ofstream backpatchDump("_patches.txt");
     backpatchDump << std::left;
     for (Backpatch iter : program.patches) {
-        backpatchDump << std::setw(30) << iter.name << "  ";
+        std::stringstream name;
+        name << iter.value;
+        backpatchDump << std::setw(30) << name.str() << "  ";
         backpatchDump << iter.width << "  ";
         backpatchDump << iter.pos << "\n";
     }
@@ -179,8 +217,8 @@ void dumpSymbols(const Program &program) {
     labelValues << std::left;
     for (auto iter : program.symbolTable) {
         labelValues << std::setw(identifierWidth) << iter.first << "  ";
-        if (!iter.second.value.identifier.empty()) {
-            labelValues << iter.second.value.identifier;
+        if (!iter.second.value.isConstant()) {
+            labelValues << iter.second.value;
         } else {
             labelValues << iter.second.value.value << " (0x";
             labelValues << std::hex << iter.second.value.value << std::dec << ')';
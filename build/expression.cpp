@@ -0,0 +1,131 @@
+/* ************************************************************************* *
+ * CONSTANT EXPRESSIONS                                                      *
+ * ************************************************************************* */
+
+#include <string>
+#include <vector>
+
+#include "assemble.h"
+
+// symbols referring to other symbols are followed at most this deep, which
+// also catches definitions that refer back to themselves
+const int MAX_EXPRESSION_DEPTH = 32;
+
+static void appendTerms(std::vector<ExprTerm> &terms, const Value &value) {
+    if (!value.expression.empty()) {
+        terms.insert(terms.end(), value.expression.begin(), value.expression.end());
+    } else {
+        terms.push_back(ExprTerm{ 0, value.value, value.identifier });
+    }
+}
+
+// Apply op using 32-bit wrap around arithmetic, the same as the VM does.
+static bool applyOperator(ErrorLog &errorLog, const Origin &origin, char op, int lhs, int rhs, int &result) {
+    unsigned ulhs = static_cast<unsigned>(lhs);
+    unsigned urhs = static_cast<unsigned>(rhs);
+    switch(op) {
+        case '+':
+            result = static_cast<int>(ulhs + urhs);
+            return true;
+        case '-':
+            result = static_cast<int>(ulhs - urhs);
+            return true;
+        case '*':
+            result = static_cast<int>(ulhs * urhs);
+            return true;
+        case '/':
+        case '%':
+            if (rhs == 0) {
+                errorLog.add(origin, "Division by zero in constant expression.");
+                return false;
+            }
+            if (rhs == -1) {
+                // avoid overflow trap on INT_MIN / -1
+                result = op == '/' ? static_cast<int>(0 - ulhs) : 0;
+                return true;
+            }
+            result = op == '/' ? lhs / rhs : lhs % rhs;
+            return true;
+        default:
+            errorLog.add(origin, std::string("(internal) Unknown expression operator ") + op + ".");
+            return false;
+    }
+}
+
+Value makeExpression(ErrorLog &errorLog, const Origin &origin, const Value &lhs, char op, const Value &rhs) {
+    if (lhs.isConstant() && rhs.isConstant()) {
+        int result = 0;
+        if (!applyOperator(errorLog, origin, op, lhs.value, rhs.value, result)) {
+            return Value{0};
+        }
+        return Value{result};
+    }
+
+    Value expr;
+    appendTerms(expr.expression, lhs);
+    appendTerms(expr.expression, rhs);
+    expr.expression.push_back(ExprTerm{ op, 0, "" });
+    return expr;
+}
+
+static bool evaluateCore(Program &code, const Origin &origin, const Value &value, int &result, std::string &undefinedName, int depth);
+
+static bool evaluateIdentifier(Program &code, const Origin &origin, const std::string &name, int &result, std::string &undefinedName, int depth) {
+    if (depth > MAX_EXPRESSION_DEPTH) {
+        code.errorLog.add(origin, "Symbol " + name + " is defined in terms of itself.");
+        return false;
+    }
+    const SymbolDef &symbol = code.getSymbol(name);
+    if (!symbol.valid) {
+        undefinedName = name;
+        return false;
+    }
+    return evaluateCore(code, origin, symbol.value, result, undefinedName, depth + 1);
+}
+
+static bool evaluateCore(Program &code, const Origin &origin, const Value &value, int &result, std::string &undefinedName, int depth) {
+    if (value.expression.empty()) {
+        if (value.identifier.empty()) {
+            result = value.value;
+            return true;
+        }
+        return evaluateIdentifier(code, origin, value.identifier, result, undefinedName, depth);
+    }
+
+    std::vector<int> stack;
+    for (const ExprTerm &term : value.expression) {
+        if (term.op == 0) {
+            int termValue = term.value;
+            if (!term.identifier.empty()) {
+                if (!evaluateIdentifier(code, origin, term.identifier, termValue, undefinedName, depth)) {
+                    return false;
+                }
+            }
+            stack.push_back(termValue);
+        } else {
+            if (stack.size() < 2) {
+                code.errorLog.add(origin, "(internal) Malformed constant expression.");
+                return false;
+            }
+            int rhs = stack.back();
+            stack.pop_back();
+            if (!applyOperator(code.errorLog, origin, term.op, stack.back(), rhs, stack.back())) {
+                return false;
+            }
+        }
+    }
+    if (stack.size() != 1) {
+        code.errorLog.add(origin, "(internal) Malformed constant expression.");
+        return false;
+    }
+    result = stack.back();
+    return true;
+}
+
+// Determine the final value of a (possibly symbolic) value. Returns false if
+// any symbol it relies on is not yet defined, in which case undefinedName is
+// set to the first such symbol.
+bool evaluateValue(Program &code, const Origin &origin, const Value &value, int &result, std::string &undefinedName) {
+    undefinedName.clear();
+    return evaluateCore(code, origin, value, result, undefinedName, 0);
+}
@@ -0,0 +1,75 @@
+/* ************************************************************************* *
+ * CONSTANT FOLDING                                                          *
+ * ************************************************************************* */
+
+#include <iostream>
+#include <vector>
+
+#include "assemble.h"
+
+static AsmCode* asPush(AsmLine *line) {
+    AsmCode *asmcode = dynamic_cast<AsmCode*>(line);
+    if (asmcode && asmcode->mnemonic.opcode == Opcode::pushw) return asmcode;
+    return nullptr;
+}
+
+static char arithmeticOperator(Opcode opcode) {
+    switch(opcode) {
+        case Opcode::add:   return '+';
+        case Opcode::sub:   return '-';
+        case Opcode::mul:   return '*';
+        case Opcode::div:   return '/';
+        case Opcode::mod:   return '%';
+        default:            return 0;
+    }
+}
+
+// Collapse "push a; push b; <arith>" and "push a; inc/dec" sequences into a
+// single push of a constant expression. Since every pushed operand is either
+// a number or a symbol, the result is always computable once labels are
+// placed. A label between the instructions is a possible jump target, so
+// sequences are never folded across one.
+void foldConstants(Program &code) {
+    std::vector<AsmLine*> folded;
+    unsigned removedBytes = 0;
+
+    for (AsmLine *line : code.code) {
+        AsmCode *asmcode = dynamic_cast<AsmCode*>(line);
+        if (!asmcode) {
+            folded.push_back(line);
+            continue;
+        }
+
+        const Opcode opcode = asmcode->mnemonic.opcode;
+        char op = arithmeticOperator(opcode);
+        if (op != 0 && folded.size() >= 2) {
+            AsmCode *lhs = asPush(folded[folded.size() - 2]);
+            AsmCode *rhs = asPush(folded[folded.size() - 1]);
+            // leave literal division by zero for the VM to report at run time
+            bool divByZero = (op == '/' || op == '%') && rhs && rhs->operandValue.isConstant()
+                             && rhs->operandValue.value == 0;
+            if (lhs && rhs && !divByZero) {
+                lhs->operandValue = makeExpression(code.errorLog, asmcode->origin,
+                                                   lhs->operandValue, op, rhs->operandValue);
+                folded.pop_back();
+                delete rhs;
+                delete asmcode;
+                removedBytes += 1 + getMnemonic("push").operandSize + 1;
+                continue;
+            }
+        } else if ((opcode == Opcode::inc || opcode == Opcode::dec) && !folded.empty()) {
+            AsmCode *target = asPush(folded.back());
+            if (target) {
+                target->operandValue = makeExpression(code.errorLog, asmcode->origin, target->operandValue,
+                                                      opcode == Opcode::inc ? '+' : '-', Value{1});
+                delete asmcode;
+                removedBytes += 1;
+                continue;
+            }
+        }
+        folded.push_back(line);
+    }
+
+    code.code.swap(folded);
+    std::cerr << "Folded: " << removedBytes << "\n";
+}
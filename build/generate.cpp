@@ -17,34 +17,33 @@ void write8(std::ostream &out, std::uint8_t value) {
     out.write(reinterpret_cast<const char*>(&value), 1);
 }
 
-void writeValue(Program &code, const Origin &origin, std::ostream &out, unsigned filePos, int width, const Value &value) {
-    if (value.identifier.empty()) {
-        switch(width) {
-            case 1:
-                write8(out, value.value);
-                break;
-            case 2:
-                write16(out, value.value);
-                break;
-            case 4:
-                write32(out, value.value);
-                break;
-            default:
-                // code.errorLog.add(Origin(), "(internal) Unhandled value width " + std::to_string(width));
-                break;
-        }
-    } else {
-        if (filePos == 0) return; // signals updating backpatches; we should never create more at this point
-
-        const SymbolDef &symbol = code.getSymbol(value.identifier);
-        if (symbol.valid) {
-            writeValue(code, origin, out, filePos, width, symbol.value);
-        } else {
+void writeValue(Program &code, const Origin &origin, std::ostream &out, int width, const Value &value) {
+    int result = 0x7FFFFFFF;
+    if (!value.isConstant()) {
+        std::string undefinedName;
+        if (!evaluateValue(code, origin, value, result, undefinedName) && !undefinedName.empty()) {
+            // not known yet (usually a forward label); resolve once everything is placed
             unsigned long pos = out.tellp();
-            Backpatch patch{ origin, pos, value.identifier, width };
+            Backpatch patch{ origin, pos, value, width };
             code.patches.push_back(patch);
-            writeValue(code, origin, out, filePos, width, Value{0x7FFFFFFF});
         }
+    } else {
+        result = value.value;
+    }
+
+    switch(width) {
+        case 1:
+            write8(out, result);
+            break;
+        case 2:
+            write16(out, result);
+            break;
+        case 4:
+            write32(out, result);
+            break;
+        default:
+            // code.errorLog.add(Origin(), "(internal) Unhandled value width " + std::to_string(width));
+            break;
     }
 }
 
@@ -61,12 +60,12 @@ void generate(Program &code, const std::string &outputFile) {
             write8(outfile, static_cast<int>(asmcode->mnemonic.opcode));
             ++filePos;
             if (asmcode->mnemonic.operandSize > 0) {
-                writeValue(code, asmcode->origin, outfile, filePos, asmcode->mnemonic.operandSize, asmcode->operandValue);
+                writeValue(code, asmcode->origin, outfile, asmcode->mnemonic.operandSize, asmcode->operandValue);
                 filePos += asmcode->mnemonic.operandSize;
             }
         } else if (data) {
             for (const Value &value : data->data) {
-                writeValue(code, data->origin, outfile, filePos, data->width, value);
+                writeValue(code, data->origin, outfile, data->width, value);
                 filePos += data->width;
             }
         } else if (label) {
@@ -77,12 +76,15 @@ void generate(Program &code, const std::string &outputFile) {
     }
 
     for (Backpatch patch : code.patches) {
-        const SymbolDef &symbol = code.getSymbol(patch.name);
-        if (!symbol.valid) {
-            code.errorLog.add(patch.origin, "Undefined symbol " + patch.name);
+        int result = 0;
+        std::string undefinedName;
+        if (!evaluateValue(code, patch.origin, patch.value, result, undefinedName)) {
+            if (!undefinedName.empty()) {
+                code.errorLog.add(patch.origin, "Undefined symbol " + undefinedName);
+            }
         } else {
             outfile.seekp(patch.pos);
-            writeValue(code, patch.origin, outfile, 0, patch.width, symbol.value);
+            writeValue(code, patch.origin, outfile, patch.width, Value{result});
         }
     }
 }
@@ -9,6 +9,7 @@
 std::string anonymousString(ParseState &state, const std::string &text);
 bool buildPush(ParseState &state, const Origin &origin, const Value &value);
 Value tokenToValue(ParseState &state);
+Value parseExpression(ParseState &state);
 
 void unescapeString(std::string &text) {
     for (unsigned i = 0; i < text.size(); ++i) {
@@ -29,6 +30,7 @@ void unescapeString(std::string &text) {
 
 std::vector<Token> parseLine(const std::string &line, const std::string &filename, int lineNo) {
     std::vector<Token> tokens;
+    int parenDepth = 0;
 
     std::string::size_type pos = 0;
     while (pos < line.size()) {
@@ -59,6 +61,27 @@ std::vector<Token> parseLine(const std::string &line, const std::string &filenam
             ++pos;
             tokens.push_back(Token{origin, TokenType::At});
 
+        } else if (line[pos] == '(' || line[pos] == ')') {
+            int column = pos + 1;
+            Origin origin{ filename, lineNo, column};
+            if (line[pos] == '(') {
+                ++parenDepth;
+                tokens.push_back(Token{origin, TokenType::OpenParen});
+            } else {
+                --parenDepth;
+                tokens.push_back(Token{origin, TokenType::CloseParen});
+            }
+            ++pos;
+
+        } else if (line[pos] == '+' || line[pos] == '*' || line[pos] == '/' || line[pos] == '%'
+                    || (line[pos] == '-' && parenDepth > 0)) {
+            // inside an expression, '-' is always an operator; negation is
+            // handled by the expression parser
+            int column = pos + 1;
+            Origin origin{ filename, lineNo, column};
+            tokens.push_back(Token{origin, TokenType::Operator, std::string(1, line[pos])});
+            ++pos;
+
         } else if (line[pos] == '-' || g_is_digit(line[pos])) {
             int column = pos + 1;
             Origin origin{ filename, lineNo, column};
@@ -125,6 +148,8 @@ bool parseData(ParseState &state, int width) {
     while (state.here().type != TokenType::EOL) {
         if (state.here().type == TokenType::Identifier) {
             data->data.push_back(Value(state.here().text));
+        } else if (state.matches(TokenType::OpenParen)) {
+            data->data.push_back(parseExpression(state));
         } else if (state.require(TokenType::Integer)) {
             data->data.push_back(Value{state.here().i});
         }
@@ -143,8 +168,7 @@ bool parseDefine(ParseState &state) {
     const std::string &name = state.here().text;
     state.advance();
 
-    if (!state.require(TokenType::Integer)) return false;
-    SymbolDef newSymbol(origin, Value{state.here().i});
+    SymbolDef newSymbol(origin, tokenToValue(state));
     state.code.addSymbol(name, newSymbol);
 
     state.advance();
@@ -726,8 +750,73 @@ bool buildPush(ParseState &state, const Origin &origin, const Value &value) {
     return true;
 }
 
+Value parseExpressionTerm(ParseState &state);
+
+bool isOperator(ParseState &state, const char *ops) {
+    if (!state.matches(TokenType::Operator)) return false;
+    for (const char *op = ops; *op; ++op) {
+        if (state.here().text[0] == *op) return true;
+    }
+    return false;
+}
+
+Value parseExpressionFactor(ParseState &state) {
+    const Origin &origin = state.here().origin;
+    if (isOperator(state, "-")) {
+        state.advance();
+        return makeExpression(state.errorLog, origin, Value{0}, '-', parseExpressionFactor(state));
+    } else if (state.matches(TokenType::OpenParen)) {
+        state.advance();
+        Value value = parseExpressionTerm(state);
+        if (state.require(TokenType::CloseParen)) state.advance();
+        return value;
+    } else if (state.matches(TokenType::Identifier)) {
+        Value value(state.here().text);
+        state.advance();
+        return value;
+    } else if (state.require(TokenType::Integer)) {
+        Value value{state.here().i};
+        state.advance();
+        return value;
+    }
+    return Value{0};
+}
+
+Value parseExpressionProduct(ParseState &state) {
+    Value value = parseExpressionFactor(state);
+    while (isOperator(state, "*/%")) {
+        const Origin &origin = state.here().origin;
+        char op = state.here().text[0];
+        state.advance();
+        value = makeExpression(state.errorLog, origin, value, op, parseExpressionFactor(state));
+    }
+    return value;
+}
+
+Value parseExpressionTerm(ParseState &state) {
+    Value value = parseExpressionProduct(state);
+    while (isOperator(state, "+-")) {
+        const Origin &origin = state.here().origin;
+        char op = state.here().text[0];
+        state.advance();
+        value = makeExpression(state.errorLog, origin, value, op, parseExpressionProduct(state));
+    }
+    return value;
+}
+
+// Parse a parenthesized constant expression. Like tokenToValue, this leaves
+// the parser on the final token of the expression (the closing paren).
+Value parseExpression(ParseState &state) {
+    state.advance(); // skip (
+    Value value = parseExpressionTerm(state);
+    state.require(TokenType::CloseParen);
+    return value;
+}
+
 Value tokenToValue(ParseState &state) {
-    if (state.here().type == TokenType::Identifier) {
+    if (state.matches(TokenType::OpenParen)) {
+        return parseExpression(state);
+    } else if (state.here().type == TokenType::Identifier) {
         return Value(state.here().text);
     } else if (state.matches(TokenType::String)) {
         std::string label = anonymousString(state, state.here().origin, state.here().text);
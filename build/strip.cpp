@@ -0,0 +1,151 @@
+/* ************************************************************************* *
+ * DEAD CODE AND DATA STRIPPING                                              *
+ * ************************************************************************* */
+
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "assemble.h"
+
+// A block is a run of lines starting at a label (or at the start of the
+// program) and ending just before the next label. Blocks are the unit of
+// stripping; a block is either kept whole or removed whole.
+struct StripBlock {
+    unsigned first, last;   // [first, last) into Program::code
+    std::vector<std::string> references;
+    bool reached;
+};
+
+static bool isTerminator(const AsmLine *line) {
+    const AsmCode *asmcode = dynamic_cast<const AsmCode*>(line);
+    if (!asmcode) return false;
+    switch(asmcode->mnemonic.opcode) {
+        case Opcode::exit:
+        case Opcode::ret:
+        case Opcode::jump:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool isData(const AsmLine *line) {
+    return dynamic_cast<const AsmData*>(line) != nullptr;
+}
+
+// Determine if execution (for code) or sequential reads (for data, such as
+// the npc lists used by mf_addactors) can run off the end of a block into the
+// one following it. Strings are zero terminated, so are never read past.
+static bool fallsThrough(const Program &code, const StripBlock &block, const StripBlock &next) {
+    unsigned nextStart = next.first + 1; // skip the block's label
+    const AsmLine *lastLine = code.code[block.last - 1];
+    if (dynamic_cast<const AsmLabel*>(lastLine)) return true;
+    if (isData(lastLine)) {
+        if (static_cast<const AsmData*>(lastLine)->fromString) return false;
+        return nextStart < next.last && isData(code.code[nextStart]);
+    }
+    return !isTerminator(lastLine);
+}
+
+static void addReference(const Program &code, StripBlock &block, const Value &value, unsigned depth = 0);
+
+// Names defined with .define stand for their value, which may itself name a
+// label, so follow them through to whatever they refer to. The depth limit
+// stops a define that refers to itself from recursing forever; resolving the
+// value later reports it as undefined.
+static void addIdentifier(const Program &code, StripBlock &block, const std::string &name, unsigned depth) {
+    block.references.push_back(name);
+    auto symbol = code.symbolTable.find(name);
+    if (symbol != code.symbolTable.end() && depth < 16) {
+        addReference(code, block, symbol->second.value, depth + 1);
+    }
+}
+
+static void addReference(const Program &code, StripBlock &block, const Value &value, unsigned depth) {
+    if (!value.identifier.empty()) {
+        addIdentifier(code, block, value.identifier, depth);
+    }
+    for (const ExprTerm &term : value.expression) {
+        if (!term.identifier.empty()) {
+            addIdentifier(code, block, term.identifier, depth);
+        }
+    }
+}
+
+void stripUnreachable(Program &code) {
+    std::vector<StripBlock> blocks;
+    std::map<std::string, unsigned> labelBlocks;
+
+    for (unsigned i = 0; i < code.code.size(); ++i) {
+        const AsmLine *line = code.code[i];
+        const AsmLabel *label = dynamic_cast<const AsmLabel*>(line);
+        if (label || blocks.empty()) {
+            if (!blocks.empty()) blocks.back().last = i;
+            blocks.push_back(StripBlock{ i, i, {}, false });
+            if (label) labelBlocks.insert(std::make_pair(label->name, blocks.size() - 1));
+        }
+
+        const AsmCode *asmcode = dynamic_cast<const AsmCode*>(line);
+        const AsmData *data = dynamic_cast<const AsmData*>(line);
+        if (asmcode && asmcode->mnemonic.operandSize > 0) {
+            addReference(code, blocks.back(), asmcode->operandValue);
+        } else if (data) {
+            for (const Value &value : data->data) {
+                addReference(code, blocks.back(), value);
+            }
+        }
+    }
+    if (blocks.empty()) return;
+    blocks.back().last = code.code.size();
+
+    // the header (and through it the exports table) is always live
+    std::vector<unsigned> worklist;
+    worklist.push_back(0);
+    for (const std::string &name : code.exports) {
+        auto iter = labelBlocks.find(name);
+        if (iter != labelBlocks.end()) worklist.push_back(iter->second);
+    }
+
+    while (!worklist.empty()) {
+        unsigned index = worklist.back();
+        worklist.pop_back();
+        if (blocks[index].reached) continue;
+        blocks[index].reached = true;
+
+        for (const std::string &name : blocks[index].references) {
+            auto iter = labelBlocks.find(name);
+            // anything else is a constant or table index; not an address
+            if (iter != labelBlocks.end()) worklist.push_back(iter->second);
+        }
+        if (index + 1 < blocks.size() && fallsThrough(code, blocks[index], blocks[index + 1])) {
+            worklist.push_back(index + 1);
+        }
+    }
+
+    std::vector<AsmLine*> keptLines;
+    unsigned strippedBlocks = 0, strippedBytes = 0;
+    for (const StripBlock &block : blocks) {
+        for (unsigned i = block.first; i < block.last; ++i) {
+            AsmLine *line = code.code[i];
+            if (block.reached) {
+                keptLines.push_back(line);
+                continue;
+            }
+            code.stripped.push_back(line);
+
+            const AsmCode *asmcode = dynamic_cast<const AsmCode*>(line);
+            const AsmData *data = dynamic_cast<const AsmData*>(line);
+            if (asmcode) {
+                strippedBytes += 1 + asmcode->mnemonic.operandSize;
+            } else if (data) {
+                strippedBytes += data->data.size() * data->width;
+            }
+        }
+        if (!block.reached) ++strippedBlocks;
+    }
+    code.code.swap(keptLines);
+
+    std::cerr << "Stripped: " << strippedBytes << " (" << strippedBlocks << " blocks)\n";
+}
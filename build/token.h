@@ -10,6 +10,9 @@ enum class TokenType {
     Colon,
     At,
     Equals,
+    OpenParen,
+    CloseParen,
+    Operator,
     EOL
 };
 
@@ -32,10 +32,23 @@ int ActorType::typeCount() {
 }
 
 
-Actor::Actor(int type)
-: level(1), xp(0), curHealth(0), curEnergy(0), isPlayer(false),
-  talkFunc(0), talkArg(0),
-  ai_lastDir(Dir::None), ai_lastTarget(-1, -1), ai_moveCount(0), hasProperName(false)
+ActorDetails::ActorDetails()
+: talkFunc(0), talkArg(0), hasProperName(false)
+{ }
+
+// Reset for reuse by another actor; the string and path keep their storage.
+void ActorDetails::clear() {
+    name.clear();
+    talkFunc = 0;
+    talkArg = 0;
+    hasProperName = false;
+    ai_lastPath.clear();
+}
+
+Actor::Actor(int type, ActorDetails *details)
+: id(0), level(1), xp(0), curHealth(0), curEnergy(0), nextAction(noAction), scheduleOrder(0), isPlayer(false),
+  ai_lastDir(Dir::None), ai_lastTarget(-1, -1), ai_pathNext(0),
+  details(details)
 {
     typeIdent = type;
     typeInfo = &ActorType::get(type);
@@ -43,9 +56,9 @@ Actor::Actor(int type)
 
 std::string Actor::getName() const {
     std::stringstream result;
-    if (!hasProperName) result << "the ";
-    if (name.empty()) result << typeInfo->name;
-    else result << name + " (" + typeInfo->name + ")";
+    if (!details->hasProperName) result << "the ";
+    if (details->name.empty()) result << typeInfo->name;
+    else result << details->name + " (" + typeInfo->name + ")";
     return result.str();
 }
 
@@ -70,14 +83,44 @@ bool Actor::isKOed() const {
     return curHealth <= 0;
 }
 
-void Actor::ai(GameState &system) {
-    // actors have a 1 in moveRate chance of taking a turn
-    if (typeInfo->moveRate > 1) {
-        ++ai_moveCount;
-        if (ai_moveCount < typeInfo->moveRate) return;
-        ai_moveCount = 0;
+// Actors that never act on their own are left out of the board's schedule.
+bool Actor::hasAI() const {
+    switch(typeInfo->aiType) {
+        case aiPlayer:
+        case aiStill:
+        case aiPushable:
+        case aiBreakable:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// Board time between one action and the next.
+int Actor::actionDelay() const {
+    if (typeInfo->moveRate > 1) return typeInfo->moveRate * turnLength;
+    return turnLength;
+}
+
+bool Actor::needsPlan() const {
+    return typeInfo->aiType == aiEnemy;
+}
+
+// Called from worker threads; this must only read from the board.
+void Actor::planAI(const Board &board, const Point &playerPos, AIPlan &plan) const {
+    plan.path.clear();
+    if (board.hasSymmetricFOV()) {
+        // whatever the player can see can see the player
+        plan.canSeePlayer = board.inView(position);
+    } else {
+        plan.canSeePlayer = board.canSee(position, playerPos);
     }
+    if (plan.canSeePlayer && position.distanceTo(playerPos) >= 2) {
+        plan.path = board.findPath(position, playerPos);
+    }
+}
 
+void Actor::ai(GameState &system, AIPlan &plan) {
     // dead things don't do AI
     if (curHealth <= 0) return;
     Board *board = system.getBoard();
@@ -90,21 +133,20 @@ void Actor::ai(GameState &system) {
             if (ai_pathNext <= 0) {
                 system.addMessage("A bomb explodes!");
                 Dir d = Dir::North;
-                AnimFrame frame(animFrame);
                 SDL_Texture *boom = system.getImage("effects/boom.png");
+                const unsigned start = system.animations.now();
                 do {
                     Point work = position.shift(d);
-                    frame.data.insert(std::make_pair(work, boom));
+                    system.animations.addSprite(start, system.animationDelay(), work, boom);
                     Actor *who = board->actorAt(work);
                     if (who && (who->typeInfo->aiType == aiPlayer ||
                                 who->typeInfo->aiType == aiBreakable ||
                                 who->typeInfo->aiType == aiEnemy)) {
-                        int damage = system.coreRNG.roll(4, 4);
+                        int damage = system.combatRNG.roll(4, 4);
                         board->doDamage(system, who, damage, 0, "bomb");
                     }
                     d = rotateDirection45(d);
                 } while (d != Dir::North);
-                system.queueFrame(frame);
                 curHealth = 0;
                 position = Point(-1, -1);
             }
@@ -114,24 +156,10 @@ void Actor::ai(GameState &system) {
         case aiPushable:
             return;
         case aiPaceHorz:
-            if (ai_lastDir == Dir::None) ai_lastDir = Dir::East;
         case aiPaceVert:
-            if (ai_lastDir == Dir::None) ai_lastDir = Dir::North;
-            if (!tryMove(board, ai_lastDir)) {
-                ai_lastDir = flipDirection(ai_lastDir);
-                tryMove(board, ai_lastDir);
-            }
-            break;
         case aiRandom:
-            ai_lastDir = dirs[rand() % 4];
-            tryMove(board, ai_lastDir);
-            break;
         case aiPaceBox:
-            if (ai_lastDir == Dir::None) ai_lastDir = Dir::West;
-            if (!tryMove(board, ai_lastDir)) {
-                ai_lastDir = rotateDirection(ai_lastDir);
-                tryMove(board, ai_lastDir);
-            }
+            patternMove(board, system.aiRNG);
             break;
         case aiAvoidPlayer:
             ai_lastDir = position.directionTo(board->getPlayer()->position);
@@ -143,8 +171,7 @@ void Actor::ai(GameState &system) {
             break;
         case aiEnemy: {
             Point playerPos = board->getPlayer()->position;
-            bool canSeePlayer = board->canSee(position, playerPos);
-            if (canSeePlayer) {
+            if (plan.canSeePlayer) {
                 ai_lastTarget = playerPos;
                 if (position.distanceTo(playerPos) < 2) {
                     Actor *player = board->getPlayer();
@@ -159,31 +186,31 @@ void Actor::ai(GameState &system) {
                 } else {
                     // move towards player
                     // std::cerr << this << " can see player\n";
-                    ai_lastPath = board->findPath(position, playerPos);
-                    if (ai_lastPath.size() < 2) {
+                    details->ai_lastPath.swap(plan.path);
+                    if (details->ai_lastPath.size() < 2) {
                         // std::cerr << this << " no valid path to player\n";
                         break;
                     }
                     ai_pathNext = 2;
-                    // std::cerr << this << " trying to move to " << ai_lastPath[1] << "\n";
-                    ai_lastDir = position.directionTo(ai_lastPath[1]);
+                    // std::cerr << this << " trying to move to " << details->ai_lastPath[1] << "\n";
+                    ai_lastDir = position.directionTo(details->ai_lastPath[1]);
                     tryMove(board, ai_lastDir);
                 }
             } else {
                 if (ai_lastTarget.x() >= 0) {
                     // std::cerr << this << " lost sight of player\n";
-                    if (position == ai_lastTarget || ai_pathNext >= static_cast<int>(ai_lastPath.size())) {
+                    if (position == ai_lastTarget || ai_pathNext >= static_cast<int>(details->ai_lastPath.size())) {
                         // std::cerr << this << " reach last known location; wandering\n";
                         ai_lastTarget = Point(-1,-1);
-                        ai_lastDir = dirs[rand() % 4];
+                        ai_lastDir = dirs[system.aiRNG.below(4)];
                     } else {
                         // std::cerr << this << " moving to last known location\n";
-                        ai_lastDir = position.directionTo(ai_lastPath[ai_pathNext]);
+                        ai_lastDir = position.directionTo(details->ai_lastPath[ai_pathNext]);
                         ++ai_pathNext;
                     }
                 } else {
                     // std::cerr << this << " player not visible; wandering\n";
-                    ai_lastDir = dirs[rand() % 4];
+                    ai_lastDir = dirs[system.aiRNG.below(4)];
                 }
                 if (!tryMove(board, ai_lastDir)) {
                     Point newPos = position.shift(ai_lastDir);
@@ -197,6 +224,65 @@ void Actor::ai(GameState &system) {
     }
 }
 
+// Reduced AI used while catching up a board the player isn't on. Movement
+// patterns play out as normal; anything that would involve the player
+// wanders instead, and bombs fizzle out without exploding.
+void Actor::abstractAI(Board *board, Random &rng) {
+    if (curHealth <= 0) return;
+    const Dir dirs[4] = { Dir::West, Dir::North, Dir::East, Dir::South };
+
+    switch(typeInfo->aiType) {
+        case aiBomb:
+            --ai_pathNext;
+            if (ai_pathNext <= 0) {
+                curHealth = 0;
+                position = Point(-1, -1);
+            }
+            break;
+        case aiPaceHorz:
+        case aiPaceVert:
+        case aiRandom:
+        case aiPaceBox:
+            patternMove(board, rng);
+            break;
+        case aiAvoidPlayer:
+        case aiFollowPlayer:
+        case aiEnemy:
+            ai_lastTarget = Point(-1, -1);
+            ai_lastDir = dirs[rng.below(4)];
+            tryMove(board, ai_lastDir);
+            break;
+    }
+}
+
+// Movement for the AI types that don't depend on anything but the map.
+void Actor::patternMove(Board *board, Random &rng) {
+    const Dir dirs[4] = { Dir::West, Dir::North, Dir::East, Dir::South };
+
+    switch(typeInfo->aiType) {
+        case aiPaceHorz:
+            if (ai_lastDir == Dir::None) ai_lastDir = Dir::East;
+        case aiPaceVert:
+            if (ai_lastDir == Dir::None) ai_lastDir = Dir::North;
+            if (!tryMove(board, ai_lastDir)) {
+                ai_lastDir = flipDirection(ai_lastDir);
+                tryMove(board, ai_lastDir);
+            }
+            break;
+        case aiRandom:
+            ai_lastDir = dirs[rng.below(4)];
+            tryMove(board, ai_lastDir);
+            break;
+        case aiPaceBox:
+            if (ai_lastDir == Dir::None) ai_lastDir = Dir::West;
+            if (!tryMove(board, ai_lastDir)) {
+                ai_lastDir = rotateDirection(ai_lastDir);
+                tryMove(board, ai_lastDir);
+            }
+            break;
+    }
+}
+
 bool Actor::tryMove(Board *board, Dir direction) {
     Point newPosition = position.shift(direction);
 
@@ -220,8 +306,8 @@ bool doAccuracyCheck(GameState &system, Actor *attacker, Actor *target, int modi
     int roll = -10000;
     if (target->typeInfo->aiType == aiBreakable) return true;
 
-    roll = system.coreRNG.roll(1,10);
-    if (system.config->getBool("showrolls", false)) {
+    roll = system.combatRNG.roll(1,10);
+    if (system.config->settings().showRolls) {
         std::stringstream msg;
         msg << "[to hit: 1d10+" << modifier << "=" << (roll+modifier) << " > 5]";
         system.addInfo(msg.str());
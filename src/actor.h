@@ -14,6 +14,10 @@ class Random;
 struct SDL_Texture;
 
 const int playerTypeId      = 0;
+// boards number their actors from firstActorId; the player is always
+// playerActorId
+const unsigned playerActorId = 1;
+const unsigned firstActorId  = 2;
 
 const int aiPlayer          = 99;
 const int aiStill           = 0;
@@ -28,6 +32,11 @@ const int aiPushable        = 8;
 const int aiBreakable       = 9;
 const int aiBomb            = 10;
 
+// actors are scheduled on a board clock that advances turnLength units each
+// turn; an actor with a moveRate of n acts once every n turns
+const int turnLength        = 100;
+const int noAction          = -1;
+
 const int lootNone          = 0;
 const int lootTable         = 1;
 const int lootLocation      = 2;
@@ -52,34 +61,57 @@ private:
     static std::vector<ActorType> types;
 };
 
+// Actor data that is only needed now and then (names, dialogue, remembered
+// paths). It's kept apart from Actor so that the fields looked at for every
+// actor on every turn stay small and close together.
+struct ActorDetails {
+    ActorDetails();
+    void clear();
+
+    std::string name;
+    int talkFunc;
+    int talkArg;
+    bool hasProperName;
+    std::vector<Point> ai_lastPath;
+};
+
+// The read-only part of an actor's turn. Plans for every actor due to act are
+// made before any of them act, against the board as it was at the start of
+// the turn, so they can be worked out in parallel.
+struct AIPlan {
+    bool canSeePlayer;
+    std::vector<Point> path;
+};
+
 class Actor {
 public:
-    Actor(int type);
+    Actor(int type, ActorDetails *details);
 
-    std::string name;
     Point position;
     int typeIdent;
+    unsigned id;
     int level, xp;
     int curHealth, curEnergy;
 
     int nextAction;
+    unsigned scheduleOrder;
     bool isPlayer;
 
     const ActorType *typeInfo;
-    SDL_Texture *art;
-
-    int talkFunc;
-    int talkArg;
 
     Dir ai_lastDir;
     Point ai_lastTarget;
-    std::vector<Point> ai_lastPath;
     int ai_pathNext;
-    int ai_moveCount;
-    bool hasProperName;
 
+    ActorDetails *details;
 
-    void ai(GameState &system);
+    bool hasAI() const;
+    int actionDelay() const;
+    bool needsPlan() const;
+    void planAI(const Board &board, const Point &playerPos, AIPlan &plan) const;
+    void ai(GameState &system, AIPlan &plan);
+    void abstractAI(Board *board, Random &rng);
+    void patternMove(Board *board, Random &rng);
     bool tryMove(Board *board, Dir direction);
     std::string getName() const;
     void reset();
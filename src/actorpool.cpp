@@ -0,0 +1,63 @@
+#include "actorpool.h"
+
+ActorPool::ActorPool()
+: mLive(0)
+{ }
+
+Actor* ActorPool::create(int type) {
+    ++mLive;
+    if (!mFree.empty()) {
+        Actor *actor = mFree.back();
+        mFree.pop_back();
+        ActorDetails *details = actor->details;
+        details->clear();
+        *actor = Actor(type, details);
+        return actor;
+    }
+
+    if (mChunks.empty() || mChunks.back()->actors.size() >= actorPoolChunkSize) {
+        // reserve the whole chunk up front; it must never reallocate
+        std::unique_ptr<Chunk> chunk(new Chunk);
+        chunk->actors.reserve(actorPoolChunkSize);
+        chunk->details.reserve(actorPoolChunkSize);
+        mChunks.push_back(std::move(chunk));
+    }
+    Chunk &chunk = *mChunks.back();
+    chunk.details.emplace_back();
+    chunk.actors.emplace_back(type, &chunk.details.back());
+    return &chunk.actors.back();
+}
+
+void ActorPool::release(Actor *actor) {
+    if (!actor) return;
+    mFree.push_back(actor);
+    --mLive;
+}
+
+// Release every actor at once. The chunks are kept for reuse.
+void ActorPool::clear() {
+    mFree.clear();
+    for (const std::unique_ptr<Chunk> &chunk : mChunks) {
+        for (Actor &actor : chunk->actors) {
+            mFree.push_back(&actor);
+        }
+    }
+    mLive = 0;
+}
+
+bool ActorPool::owns(const Actor *actor) const {
+    for (const std::unique_ptr<Chunk> &chunk : mChunks) {
+        if (chunk->actors.empty()) continue;
+        const Actor *first = &chunk->actors.front();
+        if (actor >= first && actor <= &chunk->actors.back()) return true;
+    }
+    return false;
+}
+
+unsigned ActorPool::size() const {
+    return mLive;
+}
+
+unsigned ActorPool::capacity() const {
+    return mChunks.size() * actorPoolChunkSize;
+}
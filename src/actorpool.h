@@ -0,0 +1,37 @@
+#ifndef ACTORPOOL_H
+#define ACTORPOOL_H
+
+#include <memory>
+#include <vector>
+
+#include "actor.h"
+
+const unsigned actorPoolChunkSize = 256;
+
+// Storage for the actors on a board. Actors are allocated in fixed size
+// chunks, so an Actor* stays valid for as long as the actor exists, and
+// released slots are kept on a free list to be handed out again. The details
+// for each actor live in a matching chunk beside it.
+class ActorPool {
+public:
+    ActorPool();
+
+    Actor* create(int type);
+    void release(Actor *actor);
+    void clear();
+    bool owns(const Actor *actor) const;
+    unsigned size() const;
+    unsigned capacity() const;
+
+private:
+    struct Chunk {
+        std::vector<Actor> actors;
+        std::vector<ActorDetails> details;
+    };
+
+    std::vector<std::unique_ptr<Chunk>> mChunks;
+    std::vector<Actor*> mFree;
+    unsigned mLive;
+};
+
+#endif
@@ -0,0 +1,149 @@
+#include <algorithm>
+
+#include <SDL2/SDL.h>
+
+#include "animation.h"
+#include "board.h"
+#include "gamestate.h"
+#include "logger.h"
+
+Timeline::Timeline()
+: mActive(0), mStartTicks(0), mElapsed(0)
+{ }
+
+bool Timeline::empty() const {
+    return mActive == 0;
+}
+
+// Drop everything without letting any pending events take effect.
+void Timeline::clear() {
+    mActive = 0;
+    mSprites.clear();
+}
+
+unsigned Timeline::now() const {
+    return mActive == 0 ? 0 : mElapsed;
+}
+
+AnimEvent& Timeline::allocate(int type, unsigned start, unsigned duration) {
+    if (mActive == 0) {
+        mStartTicks = SDL_GetTicks();
+        mElapsed = 0;
+    }
+    if (mActive == mEvents.size()) mEvents.push_back(AnimEvent());
+    AnimEvent &event = mEvents[mActive++];
+    event.type = type;
+    event.start = start;
+    event.duration = duration;
+    event.texture = nullptr;
+    event.actor = nullptr;
+    event.damageAmount = event.damageType = 0;
+    event.text.clear();
+    event.done = false;
+    return event;
+}
+
+void Timeline::addSprite(unsigned start, unsigned duration, const Point &where, SDL_Texture *texture) {
+    addMotion(start, duration, where, where, texture);
+}
+
+void Timeline::addMotion(unsigned start, unsigned duration, const Point &from, const Point &to, SDL_Texture *texture) {
+    AnimEvent &event = allocate(animFrame, start, duration);
+    event.from = from;
+    event.to = to;
+    event.texture = texture;
+}
+
+void Timeline::addText(unsigned at, int type, const std::string &text) {
+    AnimEvent &event = allocate(type, at, 0);
+    event.text = text;
+}
+
+void Timeline::addDamage(unsigned at, Actor *actor, int amount, int damageType, const std::string &source) {
+    AnimEvent &event = allocate(animDamage, at, 0);
+    event.actor = actor;
+    event.damageAmount = amount;
+    event.damageType = damageType;
+    event.text = source;
+}
+
+// Events may add more events, so this works by index.
+void Timeline::fire(GameState &state, unsigned index) {
+    mEvents[index].done = true;
+    const AnimEvent &event = mEvents[index];
+    switch(event.type) {
+        case animText:
+            state.addMessage(event.text);
+            break;
+        case animRollText:
+            state.addInfo(event.text);
+            break;
+        case animDamage: {
+            std::string source = event.text;
+            state.getBoard()->doDamage(state, event.actor, event.damageAmount, event.damageType, source);
+            break; }
+        default: {
+            Logger &logger = Logger::getInstance();
+            logger.error("Unknown animation event type " + std::to_string(event.type)); }
+    }
+}
+
+// Bring the timeline up to the current time: apply any events that are due
+// and work out which sprites are showing and where.
+void Timeline::advance(GameState &state) {
+    mSprites.clear();
+    if (mActive == 0) return;
+    mElapsed = SDL_GetTicks() - mStartTicks;
+
+    mDue.clear();
+    for (unsigned i = 0; i < mActive; ++i) {
+        AnimEvent &event = mEvents[i];
+        if (event.done || event.start > mElapsed) continue;
+        if (event.type != animFrame) {
+            mDue.push_back(i);
+            continue;
+        }
+        if (mElapsed >= event.start + event.duration) {
+            event.done = true;
+            continue;
+        }
+        double progress = static_cast<double>(mElapsed - event.start) / event.duration;
+        mSprites.push_back(AnimSprite{
+            event.texture,
+            event.from.x() + (event.to.x() - event.from.x()) * progress,
+            event.from.y() + (event.to.y() - event.from.y()) * progress
+        });
+    }
+    std::stable_sort(mDue.begin(), mDue.end(), [this](unsigned a, unsigned b) {
+        return mEvents[a].start < mEvents[b].start;
+    });
+    for (unsigned index : mDue) fire(state, index);
+
+    for (unsigned i = 0; i < mActive; ++i) {
+        if (!mEvents[i].done) return;
+    }
+    mActive = 0;
+}
+
+// Skip to the end, applying every remaining event immediately.
+void Timeline::finish(GameState &state) {
+    mSprites.clear();
+    while (mActive > 0) {
+        mDue.clear();
+        for (unsigned i = 0; i < mActive; ++i) {
+            if (mEvents[i].done) continue;
+            if (mEvents[i].type == animFrame)   mEvents[i].done = true;
+            else                                mDue.push_back(i);
+        }
+        if (mDue.empty()) break;
+        std::stable_sort(mDue.begin(), mDue.end(), [this](unsigned a, unsigned b) {
+            return mEvents[a].start < mEvents[b].start;
+        });
+        for (unsigned index : mDue) fire(state, index);
+    }
+    mActive = 0;
+}
+
+const std::vector<AnimSprite>& Timeline::sprites() const {
+    return mSprites;
+}
@@ -0,0 +1,68 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <string>
+#include <vector>
+
+#include "point.h"
+
+class Actor;
+class GameState;
+struct SDL_Texture;
+
+struct AnimEvent {
+    int type;
+    unsigned start, duration;
+    // for sprites; the sprite moves from "from" to "to" over its duration
+    Point from, to;
+    SDL_Texture *texture;
+    // for damage events
+    Actor *actor;
+    int damageAmount, damageType;
+    // for damage, message, and roll events
+    std::string text;
+    bool done;
+};
+
+// a sprite to draw this frame; position is in (fractional) tiles
+struct AnimSprite {
+    SDL_Texture *texture;
+    double x, y;
+};
+
+// Pending animation events, each scheduled at a time in ms relative to when
+// the timeline started playing. Sprites are shown from their start time until
+// their duration has passed, while other events take effect once their start
+// time is reached, in order of start time. Independent sequences can be added
+// at now() to play alongside whatever is already playing.
+//
+// Events are kept in a pool that is reused once everything has played.
+class Timeline {
+public:
+    Timeline();
+
+    bool empty() const;
+    void clear();
+    unsigned now() const;
+
+    void addSprite(unsigned start, unsigned duration, const Point &where, SDL_Texture *texture);
+    void addMotion(unsigned start, unsigned duration, const Point &from, const Point &to, SDL_Texture *texture);
+    void addText(unsigned at, int type, const std::string &text);
+    void addDamage(unsigned at, Actor *actor, int amount, int damageType, const std::string &source);
+
+    void advance(GameState &state);
+    void finish(GameState &state);
+    const std::vector<AnimSprite>& sprites() const;
+
+private:
+    AnimEvent& allocate(int type, unsigned start, unsigned duration);
+    void fire(GameState &state, unsigned index);
+
+    std::vector<AnimEvent> mEvents;
+    unsigned mActive;
+    std::vector<unsigned> mDue;
+    std::vector<AnimSprite> mSprites;
+    unsigned mStartTicks, mElapsed;
+};
+
+#endif
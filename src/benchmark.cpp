@@ -0,0 +1,108 @@
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "benchmark.h"
+#include "board.h"
+#include "framestats.h"
+#include "game.h"
+#include "gamestate.h"
+#include "gfx_atlas.h"
+#include "logger.h"
+
+// The camera follows the player, so the player is walked one tile per frame
+// around a rectangle inset a quarter of the way into the board.
+static Point cameraPosition(const Board *board, int frame) {
+    const int left = board->width() / 4;
+    const int top = board->height() / 4;
+    const int right = board->width() - 1 - left;
+    const int bottom = board->height() - 1 - top;
+    const int width = right - left;
+    const int height = bottom - top;
+    const int perimeter = 2 * (width + height);
+    if (perimeter <= 0) return Point(board->width() / 2, board->height() / 2);
+
+    int step = frame % perimeter;
+    if (step < width)   return Point(left + step, top);
+    step -= width;
+    if (step < height)  return Point(right, top + step);
+    step -= height;
+    if (step < width)   return Point(right - step, bottom);
+    step -= width;
+    return Point(left, bottom - step);
+}
+
+static void writeSummary(std::ostream &out, const std::string &name, const FrameSummary &summary) {
+    out << "\"" << name << "\":{";
+    out << "\"mean\":" << summary.mean << ",\"min\":" << summary.min << ",\"p50\":" << summary.p50;
+    out << ",\"p95\":" << summary.p95 << ",\"p99\":" << summary.p99 << ",\"max\":" << summary.max << "}";
+}
+
+// Draw the map, sidebar, and a tooltip for a fixed number of frames along a
+// fixed path and write the frame times and draw call counts to stdout as a
+// single JSON object.
+int runBenchmark(GameState &state, const BenchmarkOptions &options) {
+    Logger &log = Logger::getInstance();
+    try {
+        state.finishLoading();
+        state.reset();
+    } catch (GameError &e) {
+        log.error(std::string("Benchmark failed to load game: ") + e.what());
+        return 1;
+    }
+    if (!state.warpTo(options.mapIndex, 0, 0)) {
+        log.error("Benchmark map " + std::to_string(options.mapIndex) + " does not exist.");
+        return 1;
+    }
+    Board *board = state.getBoard();
+    board->dbgRevealAll();
+    state.showTooltip = true;
+
+    int screenWidth = 0;
+    int screenHeight = 0;
+    SDL_GetRendererOutputSize(state.renderer, &screenWidth, &screenHeight);
+    const int sidebarWidth = 30 * state.smallFont->getCharWidth();
+    const int tooltipX = (screenWidth - sidebarWidth) / 2;
+    const int tooltipY = screenHeight / 2;
+
+    std::vector<double> frameTimes, drawCalls;
+    const double frequency = SDL_GetPerformanceFrequency();
+    for (int frame = 0; frame < options.frames; ++frame) {
+        const Point position = cameraPosition(board, frame);
+        state.warpTo(-1, position.x(), position.y());
+        board->calcFOV(position);
+
+        gfxDrawCalls = 0;
+        const Uint64 start = SDL_GetPerformanceCounter();
+        SDL_SetRenderDrawColor(state.renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+        SDL_RenderClear(state.renderer);
+        ++gfxDrawCalls;
+        gfx_drawMap(state);
+        gfx_drawSidebar(state);
+        gfx_drawToolTipAt(state, tooltipX, tooltipY);
+        SDL_RenderPresent(state.renderer);
+        const Uint64 end = SDL_GetPerformanceCounter();
+
+        frameTimes.push_back((end - start) * 1000.0 / frequency);
+        drawCalls.push_back(gfxDrawCalls);
+        SDL_PumpEvents();
+    }
+
+    SDL_RendererInfo info;
+    std::string rendererName = "unknown";
+    if (SDL_GetRendererInfo(state.renderer, &info) == 0) rendererName = info.name;
+
+    const FrameSummary times = summarizeFrameTimes(frameTimes);
+    const FrameSummary calls = summarizeFrameTimes(drawCalls);
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "{\"renderer\":\"" << rendererName << "\",\"map\":" << options.mapIndex;
+    std::cout << ",\"width\":" << screenWidth << ",\"height\":" << screenHeight;
+    std::cout << ",\"frames\":" << times.count << ",";
+    writeSummary(std::cout, "frame_ms", times);
+    std::cout << ",";
+    writeSummary(std::cout, "draw_calls", calls);
+    std::cout << "}\n";
+    return 0;
+}
@@ -0,0 +1,17 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+class GameState;
+
+const int benchmarkWidth = 1280;
+const int benchmarkHeight = 720;
+const unsigned benchmarkSeed = 1;
+
+struct BenchmarkOptions {
+    int frames;
+    int mapIndex;
+};
+
+int runBenchmark(GameState &state, const BenchmarkOptions &options);
+
+#endif
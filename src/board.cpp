@@ -6,14 +6,18 @@
 #include <sstream>
 #include <vector>
 #include <physfs.h>
+#include <SDL2/SDL.h>
 
 #include "board.h"
 #include "actor.h"
 #include "point.h"
 #include "random.h"
+#include "game.h"
 #include "gamestate.h"
 #include "logger.h"
+#include "savegame.h"
 #include "vm.h"
+#include "workerpool.h"
 #include "textutil.h"
 
 
@@ -21,6 +25,7 @@ std::vector<TileInfo> TileInfo::types;
 
 const TileInfo TileInfo::BAD_TILE{-1, "bad tile"};
 Board::Tile outOfBounds{ tileOutOfBounds };
+TurnProfile turnProfile{0, 0, 0, 0};
 
 bool TileInfo::is(unsigned flag) const {
     return flags & flag;
@@ -54,23 +59,22 @@ const MapInfo& MapInfo::get(int ident) {
 }
 
 Board::Board(const MapInfo &mapInfo)
-: mapInfo(mapInfo), mWidth(mapInfo.width), mHeight(mapInfo.height), dbgDisableFOV(false)
+: mapInfo(mapInfo), mWidth(mapInfo.width), mHeight(mapInfo.height),
+  nextActorId(firstActorId), currentTime(0), actionOrder(0), leftOnTurn(-1),
+  symmetricFOV(false), fovDirty(false), logTiles(false), rowVersions(mHeight, 0),
+  dbgDisableFOV(false)
 {
     tiles = new Tile[mWidth * mHeight];
     memset(tiles, 0, mWidth * mHeight * sizeof(Tile));
 }
 Board::~Board() {
     delete[] tiles;
-    for (Actor *actor : actors) {
-        delete actor;
-    }
 }
 
 void Board::reset(GameState &state) {
-    for (Actor *actor : actors) {
-        delete actor;
-    }
+    actorPool.clear();
     actors.clear();
+    actionQueue = std::priority_queue<ScheduledAction>();
     for (Item *item : items) {
         delete item;
     }
@@ -80,7 +84,7 @@ void Board::reset(GameState &state) {
     }
 }
 
-Actor* Board::actorAt(const Point &where) {
+Actor* Board::actorAt(const Point &where) const {
     for (Actor *actor : actors) {
         if (actor->position == where) {
             return actor;
@@ -88,27 +92,79 @@ Actor* Board::actorAt(const Point &where) {
     }
     return nullptr;
 }
+// Create a new actor in the board's pool and place it. The board owns the
+// actor from then on.
+Actor* Board::createActor(int type, const Point &where) {
+    Actor *actor = actorPool.create(type);
+    actor->id = nextActorId++;
+    addActor(actor, where);
+    return actor;
+}
+
+// Actors added this way (namely the player) remain owned by the caller.
 void Board::addActor(Actor *actor, const Point &where) {
     actor->position = where;
     actors.push_back(actor);
+    schedule(actor, currentTime + actor->actionDelay());
+}
+
+// Queue an actor's next action. Queue entries are never removed; any but the
+// one most recently queued for an actor is stale and is skipped.
+void Board::schedule(Actor *actor, int time) {
+    if (!actor->hasAI()) {
+        actor->nextAction = noAction;
+        return;
+    }
+    actor->nextAction = time;
+    actor->scheduleOrder = actionOrder;
+    actionQueue.push(ScheduledAction{ time, actionOrder++, actor });
 }
 
+// Remove an actor created by createActor and return it to the pool.
+void Board::destroyActor(Actor *actor) {
+    removeActor(actor);
+    actorPool.release(actor);
+}
+
+Actor* Board::actorById(unsigned id) {
+    for (Actor *actor : actors) {
+        if (actor->id == id) return actor;
+    }
+    return nullptr;
+}
+
+// Requeue every actor at its nextAction, for after actors have been changed
+// directly.
+void Board::rebuildSchedule() {
+    actionQueue = std::priority_queue<ScheduledAction>();
+    for (Actor *actor : actors) {
+        if (actor->nextAction == noAction) continue;
+        actor->scheduleOrder = actionOrder;
+        actionQueue.push(ScheduledAction{ actor->nextAction, actionOrder++, actor });
+    }
+}
+
+// Removing an actor doesn't preserve the order of the actor list.
 void Board::removeActor(Actor *actor) {
-    for (auto iter = actors.begin(); iter != actors.end();) {
-        if (*iter == actor) {
-            iter = actors.erase(iter);
+    for (unsigned i = 0; i < actors.size(); ) {
+        if (actors[i] == actor) {
+            actor->nextAction = noAction;
+            actors[i] = actors.back();
+            actors.pop_back();
         } else {
-            ++iter;
+            ++i;
         }
     }
 }
 
 void Board::removeActor(const Point &p) {
-    for (auto iter = actors.begin(); iter != actors.end();) {
-        if ((*iter)->position == p) {
-            iter = actors.erase(iter);
+    for (unsigned i = 0; i < actors.size(); ) {
+        if (actors[i]->position == p) {
+            actors[i]->nextAction = noAction;
+            actors[i] = actors.back();
+            actors.pop_back();
         } else {
-            ++iter;
+            ++i;
         }
     }
 }
@@ -139,7 +195,7 @@ void Board::makeLoot(GameState &state, const Actor *from, const Point &where) {
             break;
         case lootTable: {
             int tableNum = from->typeInfo->loot;
-            int roll = state.coreRNG.roll(1,100);
+            int roll = state.lootRNG.roll(1,100);
             const LootTable &table = state.lootTables[tableNum];
             unsigned i = 0;
             for (; i < table.rows.size(); ++i) {
@@ -218,25 +274,44 @@ void Board::clearTo(int tile) {
             tiles[x+y*mWidth].mark = false;
         }
     }
+    touchAllRows();
+}
+
+void Board::touchAllRows() {
+    for (unsigned &version : rowVersions) ++version;
 }
 
 void Board::setTile(const Point &where, int tile) {
     int t = coord(where);
     if (t < 0) return;
+    if (TileInfo::get(tiles[t].tile).is(TF_OPAQUE) != TileInfo::get(tile).is(TF_OPAQUE)) {
+        fovDirty = true;
+    }
+    if (tiles[t].tile != tile) {
+        if (logTiles) tileLog.push_back(TileChange{ where, tiles[t].tile, tile });
+        touchRow(where.y());
+    }
     tiles[t].tile = tile;
 }
+
+// While logging, every tile change is added to the tile log for the journal
+// to collect.
+void Board::setTileLogging(bool logging) {
+    logTiles = logging;
+    tileLog.clear();
+}
 int Board::getTile(const Point &where) const {
     int t = coord(where);
     if (t < 0) return tileOutOfBounds;
     return tiles[t].tile;
 }
 
-bool Board::isSolid(const Point &p) {
+bool Board::isSolid(const Point &p) const {
     const TileInfo &info = TileInfo::get(getTile(p));
     return info.is(TF_SOLID);
 }
 
-bool Board::isOpaque(const Point &p) {
+bool Board::isOpaque(const Point &p) const {
     const TileInfo &info = TileInfo::get(getTile(p));
     return info.is(TF_OPAQUE);
 }
@@ -269,8 +344,8 @@ Point Board::findTile(int tile) const {
 Point Board::findRandomTile(Random &rng, int tile) const {
     const int MAX_ITERATIONS = 1000;
     for (int i = 0; i < MAX_ITERATIONS; ++i) {
-        int x = rng.next32() % mWidth;
-        int y = rng.next32() % mHeight;
+        int x = rng.below(mWidth);
+        int y = rng.below(mHeight);
         Point here(x, y);
         if (getTile(here) == tile) return here;
     }
@@ -279,16 +354,21 @@ Point Board::findRandomTile(Random &rng, int tile) const {
 
 void Board::resetFOV() {
     for (int y = 0; y < height(); ++y) {
+        bool changed = false;
         for (int x = 0; x < width(); ++x) {
-            tiles[x+y*width()].fov &= FOV_EVER_SEEN;
+            Tile &tile = tiles[x+y*width()];
+            if (tile.fov & FOV_IN_VIEW) changed = true;
+            tile.fov &= FOV_EVER_SEEN;
         }
+        if (changed) touchRow(y);
     }
 }
 
 void Board::setSeen(const Point &where) {
     int t = coord(where);
-    if (t >= 0) {
+    if (t >= 0 && tiles[t].fov != (FOV_EVER_SEEN | FOV_IN_VIEW)) {
         tiles[t].fov |= FOV_EVER_SEEN | FOV_IN_VIEW;
+        touchRow(where.y());
     }
 }
 
@@ -299,6 +379,14 @@ bool Board::isKnown(const Point &where) const {
     return false;
 }
 
+// Whether a tile is in the player's field of view as last calculated, ignoring
+// the debug options.
+bool Board::inView(const Point &where) const {
+    int t = coord(where);
+    if (t >= 0) return tiles[t].fov & FOV_IN_VIEW;
+    return false;
+}
+
 bool Board::isVisible(const Point &where) const {
     if (dbgDisableFOV) return true;
     int t = coord(where);
@@ -307,7 +395,7 @@ bool Board::isVisible(const Point &where) const {
 }
 
 // Based on http://www.roguebasin.com/index.php?title=Bresenham%27s_Line_Algorithm
-std::vector<Point> Board::findPoints(const Point &from, const Point &to, int blockOn) {
+std::vector<Point> Board::findPoints(const Point &from, const Point &to, int blockOn) const {
     std::vector<Point> points;
 
     if (from == to) {
@@ -399,7 +487,7 @@ bool containsPoint(std::map<Point, int> container, Point value) {
     else                            return true;
 }
 
-std::vector<Point> Board::findPath(const Point &from, const Point &to) {
+std::vector<Point> Board::findPath(const Point &from, const Point &to) const {
     std::priority_queue<PathPoint, std::vector<PathPoint>> frontier;
     frontier.push(from);
     std::map<Point, Point> cameFrom;
@@ -453,7 +541,7 @@ std::vector<Point> Board::findPath(const Point &from, const Point &to) {
 }
 
 
-bool Board::canSee(const Point &from, const Point &to) {
+bool Board::canSee(const Point &from, const Point &to) const {
     std::vector<Point> points = findPoints(from, to, blockOpaque|blockTarget);
     if (points.back() == to)    return true;
     else                        return false;
@@ -475,30 +563,123 @@ const Board::Event* Board::eventAt(const Point &where) const {
     return nullptr;
 }
 
+// Advance the board clock by one turn and run every action that has come due.
+// Each turn has two phases: the plans for all due actors are made first (in
+// parallel, see planActions), then the actors act one at a time in schedule
+// order. Later actors' plans don't see what earlier actors did this turn; if
+// a planned move is blocked by then, tryMove simply fails as usual.
+//
+// The player's FOV is brought up to date before anyone acts. With symmetric
+// FOV, enemies use it to tell whether they can see the player.
 void Board::tick(GameState &system) {
-    for (Actor *who : actors) {
-        who->ai(system);
-    }
-
-    for (auto iter = actors.begin(); iter != actors.end(); ) {
-        Actor *who = *iter;
-        if (who->curHealth <= 0) {
-            iter = actors.erase(iter);
-            if (who->isPlayer) {
-                who->reset();
-                gfx_Alert(system, "You have died!", "");
-                system.vm->runFunction("onDeath");
-                system.runDirection = Dir::None;
-            } else {
-                delete who;
-            }
+    const Uint64 turnStart = SDL_GetPerformanceCounter();
+    currentTime += turnLength;
+    Actor *player = getPlayer();
+    Uint64 phaseStart = turnStart;
+    if (player) calcFOV(player->position);
+    Uint64 phaseEnd = SDL_GetPerformanceCounter();
+    turnProfile.fov += phaseEnd - phaseStart;
+    dueActors.clear();
+    while (!actionQueue.empty() && actionQueue.top().time <= currentTime) {
+        ScheduledAction action = actionQueue.top();
+        actionQueue.pop();
+        if (!action.isCurrent()) continue;
+        dueActors.push_back(action.actor);
+    }
+
+    phaseStart = phaseEnd;
+    planActions(system);
+    phaseEnd = SDL_GetPerformanceCounter();
+    turnProfile.plan += phaseEnd - phaseStart;
+    for (unsigned i = 0; i < dueActors.size(); ++i) {
+        Actor *who = dueActors[i];
+        who->ai(system, plans[i]);
+        if (who->curHealth > 0) schedule(who, who->nextAction + who->actionDelay());
+        else                    who->nextAction = noAction;
+    }
+    turnProfile.resolve += SDL_GetPerformanceCounter() - phaseEnd;
+
+    for (unsigned i = 0; i < actors.size(); ) {
+        Actor *who = actors[i];
+        if (who->curHealth > 0) {
+            ++i;
+            continue;
+        }
+        actors[i] = actors.back();
+        actors.pop_back();
+        who->nextAction = noAction;
+        if (who->isPlayer) {
+            who->reset();
+            gfx_Alert(system, "You have died!", "");
+            system.vm->runFunction("onDeath");
+            system.runDirection = Dir::None;
         } else {
-            ++iter;
+            actorPool.release(who);
         }
     }
 
+    // only needed again if something opened or closed during the turn
+    player = getPlayer();
+    if (player && fovDirty) {
+        phaseStart = SDL_GetPerformanceCounter();
+        calcFOV(player->position);
+        turnProfile.fov += SDL_GetPerformanceCounter() - phaseStart;
+    }
+    turnProfile.turn += SDL_GetPerformanceCounter() - turnStart;
+}
+
+// Plans only depend on the board as it stands, so the result is the same no
+// matter how many threads are used or how the work is divided.
+void Board::planActions(GameState &system) {
+    if (plans.size() < dueActors.size()) plans.resize(dueActors.size());
     Actor *player = getPlayer();
-    if (player) calcFOV(player->position);
+    if (!player) return;
+    const Point playerPos = player->position;
+
+    plannedActors.clear();
+    for (unsigned i = 0; i < dueActors.size(); ++i) {
+        if (dueActors[i]->needsPlan()) plannedActors.push_back(i);
+    }
+
+    const Board &board = *this;
+    WorkerJob job = [this, &board, &playerPos](int n) {
+        unsigned i = plannedActors[n];
+        dueActors[i]->planAI(board, playerPos, plans[i]);
+    };
+    if (plannedActors.size() >= minParallelPlans) {
+        system.getWorkers()->run(plannedActors.size(), job);
+    } else {
+        for (unsigned n = 0; n < plannedActors.size(); ++n) job(n);
+    }
+}
+
+// Bring a board the player has been away from up to date. Actors act in the
+// same order they would have, but only move (see Actor::abstractAI); there's
+// no one to see the results, so nothing is drawn, announced, or attacked.
+void Board::catchUp(int turns, Random &rng) {
+    if (turns <= 0) return;
+    currentTime += turns * turnLength;
+    while (!actionQueue.empty() && actionQueue.top().time <= currentTime) {
+        ScheduledAction action = actionQueue.top();
+        actionQueue.pop();
+        Actor *who = action.actor;
+        if (!action.isCurrent()) continue;
+        who->abstractAI(this, rng);
+        if (who->curHealth > 0) schedule(who, action.time + who->actionDelay());
+        else                    who->nextAction = noAction;
+    }
+
+    for (unsigned i = 0; i < actors.size(); ) {
+        Actor *who = actors[i];
+        if (who->curHealth > 0 || who->isPlayer) {
+            ++i;
+            continue;
+        }
+        actors[i] = actors.back();
+        actors.pop_back();
+        who->nextAction = noAction;
+        actorPool.release(who);
+    }
 }
 
 void Board::dbgShiftMap(Dir d) {
@@ -520,19 +701,23 @@ void Board::dbgShiftMap(Dir d) {
     }
     delete[] tiles;
     tiles = newTiles;
+    touchAllRows();
 }
 
 void Board::dbgRevealAll() {
     for (int i = 0; i < mWidth * mHeight; ++i) {
         tiles[i].fov |= FOV_EVER_SEEN;
     }
+    touchAllRows();
 }
 
 void Board::dbgToggleFOV() {
     dbgDisableFOV = !dbgDisableFOV;
+    touchAllRows();
 }
 
 void Board::dbgSetFOV(bool fovState) {
+    if (dbgDisableFOV != fovState) touchAllRows();
     dbgDisableFOV = fovState;
 }
 
@@ -567,6 +752,7 @@ bool Board::readFromFile(const std::string &filename) {
             at(Point(x, y)).tile = tile;
         }
     }
+    touchAllRows();
 
     PHYSFS_close(inf);
     return true;
@@ -588,3 +774,189 @@ bool Board::writeToFile(const std::string &filename) const {
     PHYSFS_close(inf);
     return true;
 }
+
+// Remember the map as built, which saved games are written relative to.
+void Board::markBuilt() {
+    builtTiles.resize(mWidth * mHeight);
+    for (int i = 0; i < mWidth * mHeight; ++i) {
+        builtTiles[i] = tiles[i].tile;
+    }
+}
+
+static void saveActor(SaveWriter &out, const Actor &actor) {
+    out.writeInt(actor.position.x());
+    out.writeInt(actor.position.y());
+    out.writeInt(actor.level);
+    out.writeInt(actor.xp);
+    out.writeInt(actor.curHealth);
+    out.writeInt(actor.curEnergy);
+    out.writeInt(actor.nextAction);
+    out.writeByte(static_cast<unsigned>(actor.ai_lastDir));
+    out.writeInt(actor.ai_lastTarget.x());
+    out.writeInt(actor.ai_lastTarget.y());
+    out.writeInt(actor.ai_pathNext);
+    const ActorDetails &details = *actor.details;
+    out.writeString(details.name);
+    out.writeInt(details.talkFunc);
+    out.writeInt(details.talkArg);
+    out.writeByte(details.hasProperName);
+    out.writeWord(details.ai_lastPath.size());
+    for (const Point &p : details.ai_lastPath) {
+        out.writeInt(p.x());
+        out.writeInt(p.y());
+    }
+}
+
+static void loadActor(SaveReader &in, Actor &actor) {
+    const int x = in.readInt();
+    actor.position = Point(x, in.readInt());
+    actor.level = in.readInt();
+    actor.xp = in.readInt();
+    actor.curHealth = in.readInt();
+    actor.curEnergy = in.readInt();
+    actor.nextAction = in.readInt();
+    actor.ai_lastDir = static_cast<Dir>(in.readByte());
+    const int targetX = in.readInt();
+    actor.ai_lastTarget = Point(targetX, in.readInt());
+    actor.ai_pathNext = in.readInt();
+    ActorDetails &details = *actor.details;
+    details.name = in.readString();
+    details.talkFunc = in.readInt();
+    details.talkArg = in.readInt();
+    details.hasProperName = in.readByte();
+    details.ai_lastPath.resize(in.readWord());
+    for (Point &p : details.ai_lastPath) {
+        const int pathX = in.readInt();
+        p = Point(pathX, in.readInt());
+    }
+}
+
+// Tiles are written as a list of the ones that differ from the built map and
+// the tiles that have been seen as a bitset; everything on the board is
+// written in full. Each actor's place in the schedule is kept so that actors
+// due at the same time still act in the same order.
+void Board::save(SaveWriter &out, const GameState &state) const {
+    const int size = mWidth * mHeight;
+    out.writeInt(currentTime);
+    out.writeWord(actionOrder);
+    out.writeInt(leftOnTurn);
+
+    unsigned changed = 0;
+    for (int i = 0; i < size; ++i) {
+        if (tiles[i].tile != builtTiles[i]) ++changed;
+    }
+    out.writeWord(changed);
+    for (int i = 0; i < size; ++i) {
+        if (tiles[i].tile == builtTiles[i]) continue;
+        out.writeWord(i);
+        out.writeInt(tiles[i].tile);
+    }
+    unsigned bits = 0;
+    for (int i = 0; i < size; ++i) {
+        if (tiles[i].fov & FOV_EVER_SEEN) bits |= 1 << (i % 8);
+        if (i % 8 == 7 || i + 1 == size) {
+            out.writeByte(bits);
+            bits = 0;
+        }
+    }
+
+    std::map<const Actor*, unsigned> queueOrder;
+    std::priority_queue<ScheduledAction> queue(actionQueue);
+    while (!queue.empty()) {
+        const ScheduledAction &action = queue.top();
+        if (action.isCurrent()) queueOrder.insert(std::make_pair(action.actor, action.order));
+        queue.pop();
+    }
+    out.writeWord(actors.size());
+    for (const Actor *actor : actors) {
+        out.writeByte(actor->isPlayer);
+        out.writeInt(actor->typeIdent);
+        auto order = queueOrder.find(actor);
+        out.writeWord(order != queueOrder.end() ? order->second : 0);
+        saveActor(out, *actor);
+    }
+
+    out.writeWord(items.size());
+    for (const Item *item : items) {
+        out.writeWord(item->typeInfo - state.itemDefs.data());
+        out.writeInt(item->position.x());
+        out.writeInt(item->position.y());
+        out.writeInt(item->fromLocation);
+    }
+    out.writeWord(events.size());
+    for (const Event &event : events) {
+        out.writeInt(event.pos.x());
+        out.writeInt(event.pos.y());
+        out.writeInt(event.funcAddr);
+        out.writeInt(event.type);
+    }
+}
+
+// The board must have just been built from the same seed the save was made
+// with. The player is placed on whichever board they were saved on.
+void Board::load(SaveReader &in, GameState &state) {
+    const int size = mWidth * mHeight;
+    currentTime = in.readInt();
+    actionOrder = in.readWord();
+    leftOnTurn = in.readInt();
+
+    for (int i = 0; i < size; ++i) {
+        tiles[i].tile = builtTiles[i];
+        tiles[i].mark = false;
+    }
+    const unsigned changed = in.readWord();
+    for (unsigned i = 0; i < changed; ++i) {
+        const unsigned offset = in.readWord();
+        if (offset >= static_cast<unsigned>(size)) throw GameError("Saved game has a tile outside its map.");
+        tiles[offset].tile = in.readInt();
+    }
+    const char *seen = in.readBytes((size + 7) / 8);
+    for (int i = 0; i < size; ++i) {
+        tiles[i].fov = ((seen[i / 8] >> (i % 8)) & 1) ? FOV_EVER_SEEN : 0;
+    }
+    fovDirty = true;
+    touchAllRows();
+
+    actorPool.clear();
+    actors.clear();
+    actionQueue = std::priority_queue<ScheduledAction>();
+    const unsigned actorCount = in.readWord();
+    for (unsigned i = 0; i < actorCount; ++i) {
+        const bool isPlayer = in.readByte();
+        const int type = in.readInt();
+        const unsigned order = in.readWord();
+        Actor *actor = isPlayer ? state.getPlayer() : actorPool.create(type);
+        if (!isPlayer) actor->id = nextActorId++;
+        loadActor(in, *actor);
+        actors.push_back(actor);
+        if (actor->nextAction != noAction) {
+            actor->scheduleOrder = order;
+            actionQueue.push(ScheduledAction{ actor->nextAction, order, actor });
+        }
+    }
+
+    for (Item *item : items) {
+        delete item;
+    }
+    items.clear();
+    const unsigned itemCount = in.readWord();
+    for (unsigned i = 0; i < itemCount; ++i) {
+        const unsigned itemDef = in.readWord();
+        if (itemDef >= state.itemDefs.size()) throw GameError("Saved game has an unknown item.");
+        Item *item = new Item(&state.itemDefs[itemDef]);
+        const int x = in.readInt();
+        item->position = Point(x, in.readInt());
+        item->fromLocation = in.readInt();
+        items.push_back(item);
+    }
+    events.clear();
+    const unsigned eventCount = in.readWord();
+    for (unsigned i = 0; i < eventCount; ++i) {
+        Event event;
+        const int x = in.readInt();
+        event.pos = Point(x, in.readInt());
+        event.funcAddr = in.readInt();
+        event.type = in.readInt();
+        events.push_back(event);
+    }
+}
@@ -1,17 +1,28 @@
 #ifndef BOARD_H
 #define BOARD_H
 
+#include <queue>
 #include <stdexcept>
 #include <string>
 #include <vector>
+#include "actorpool.h"
+#include "journal.h"
 #include "point.h"
 
 class GameState;
-class Actor;
 struct Item;
 class Random;
+class SaveReader;
+class SaveWriter;
 struct SDL_Texture;
 
+// time spent in each phase of Board::tick, in performance counter ticks; this
+// is only reported by replays
+struct TurnProfile {
+    unsigned long long turn, fov, plan, resolve;
+};
+extern TurnProfile turnProfile;
+
 struct TileInfo {
     int index;
     std::string name;
@@ -79,6 +90,13 @@ struct MapInfo {
     static std::vector<MapInfo> types;
 };
 
+// AI plans are only handed to the worker threads when there are at least this
+// many to make
+const unsigned minParallelPlans = 4;
+
+// the most turns a board that the player left is caught up by on their return
+const int defaultCatchUpTurns = 500;
+
 const int FOV_EVER_SEEN     = 0x01;
 const int FOV_IN_VIEW       = 0x02;
 
@@ -119,16 +137,30 @@ public:
     const MapInfo& getInfo() const {
         return mapInfo;
     }
+    // bumped whenever a tile in the row, or whether it's known or visible,
+    // changes, so views of the board can redraw only the rows that changed
+    unsigned rowVersion(int y) const {
+        return rowVersions[y];
+    }
 
     void reset(GameState &state);
-    Actor* actorAt(const Point &where);
+    Actor* actorAt(const Point &where) const;
+    Actor* createActor(int type, const Point &where);
     void addActor(Actor *actor, const Point &where);
+    void destroyActor(Actor *actor);
+    Actor* actorById(unsigned id);
     void removeActor(Actor *actor);
     void removeActor(const Point &p);
     void doDamage(GameState &state, Actor *to, int amount, int type, const std::string &source);
     void makeLoot(GameState &state, const Actor *from, const Point &where);
     Actor* getPlayer();
+    const std::vector<Actor*>& getActors() const {
+        return actors;
+    }
 
+    const std::vector<Item*>& getItems() const {
+        return items;
+    }
     Item* itemAt(const Point &where);
     void addItem(Item *item, const Point &where);
     void removeAndDeleteItem(Item *item);
@@ -137,8 +169,8 @@ public:
     void clearTo(int tile);
     void setTile(const Point &where, int tile);
     int getTile(const Point &where) const;
-    bool isSolid(const Point &p);
-    bool isOpaque(const Point &p);
+    bool isSolid(const Point &p) const;
+    bool isOpaque(const Point &p) const;
     const Tile& at(const Point &where) const;
     Tile& at(const Point &where);
     Point findTile(int tile) const;
@@ -146,17 +178,42 @@ public:
 
     void resetFOV();
     void calcFOV(const Point &origin);
+    void setSymmetricFOV(bool symmetric) {
+        symmetricFOV = symmetric;
+    }
+    bool hasSymmetricFOV() const {
+        return symmetricFOV;
+    }
+    bool inView(const Point &where) const;
     void setSeen(const Point &where);
     bool isKnown(const Point &where) const;
     bool isVisible(const Point &where) const;
-    std::vector<Point> findPoints(const Point &from, const Point &to, int blockOn);
-    std::vector<Point> findPath(const Point &from, const Point &to);
-    bool canSee(const Point &from, const Point &to);
+    std::vector<Point> findPoints(const Point &from, const Point &to, int blockOn) const;
+    std::vector<Point> findPath(const Point &from, const Point &to) const;
+    bool canSee(const Point &from, const Point &to) const;
 
     void addEvent(const Point &where, int funcAddr, int type);
     const Event* eventAt(const Point &where) const;
 
     void tick(GameState &system);
+    void catchUp(int turns, Random &rng);
+    void setLeftOnTurn(int turn) {
+        leftOnTurn = turn;
+    }
+    int getLeftOnTurn() const {
+        return leftOnTurn;
+    }
+    int getTime() const {
+        return currentTime;
+    }
+    void setTime(int time) {
+        currentTime = time;
+    }
+    void rebuildSchedule();
+    void setTileLogging(bool logging);
+    std::vector<TileChange>& getTileLog() {
+        return tileLog;
+    }
 
     void dbgShiftMap(Dir d);
     void dbgRevealAll();
@@ -166,15 +223,59 @@ public:
 
     bool readFromFile(const std::string &filename);
     bool writeToFile(const std::string &filename) const;
+    void markBuilt();
+    void save(SaveWriter &out, const GameState &state) const;
+    void load(SaveReader &in, GameState &state);
 private:
+    // a pending action in the schedule; the queue yields the earliest time
+    // first, and actions due at the same time in the order they were queued
+    struct ScheduledAction {
+        int time;
+        unsigned order;
+        Actor *actor;
+
+        bool operator<(const ScheduledAction &rhs) const {
+            if (time != rhs.time) return time > rhs.time;
+            return order > rhs.order;
+        }
+        // only the entry most recently queued for an actor is live; the
+        // order is unique on a board, so this also holds when an actor's pool
+        // slot has been reused
+        bool isCurrent() const {
+            return actor->scheduleOrder == order && actor->nextAction == time;
+        }
+    };
+
     int coord(const Point &p) const;
+    void touchRow(int y) {
+        ++rowVersions[y];
+    }
+    void touchAllRows();
+    void schedule(Actor *actor, int time);
+    void planActions(GameState &system);
+    void calcSymmetricFOV(const Point &origin);
 
     const MapInfo &mapInfo;
     int mWidth, mHeight;
     Tile *tiles;
+    std::vector<int> builtTiles;
+    ActorPool actorPool;
     std::vector<Actor*> actors;
+    unsigned nextActorId;
+    std::priority_queue<ScheduledAction> actionQueue;
+    int currentTime;
+    unsigned actionOrder;
+    int leftOnTurn;
+    std::vector<Actor*> dueActors;
+    std::vector<AIPlan> plans;
+    std::vector<unsigned> plannedActors;
     std::vector<Item*> items;
     std::vector<Event> events;
+    bool symmetricFOV;
+    bool fovDirty;
+    bool logTiles;
+    std::vector<TileChange> tileLog;
+    std::vector<unsigned> rowVersions;
     bool dbgDisableFOV;
 };
 
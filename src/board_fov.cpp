@@ -2,9 +2,13 @@
 // header file which then messes up the autocomplete/error detection for the
 // rest of the file
 
+#include <vector>
+
 #include "board.h"
 #include "fov.h"
 
+const int fovRadius = 100;
+
 void apply(void *mapVoid, int x, int y, int dx, int dy, void *src) {
     Board *map = static_cast<Board*>(mapVoid);
     map->setSeen(Point(x, y));
@@ -21,11 +25,125 @@ bool opaque(void *mapVoid, int x, int y) {
 
 void Board::calcFOV(const Point &origin) {
     resetFOV();
+    fovDirty = false;
+    if (symmetricFOV) {
+        calcSymmetricFOV(origin);
+        return;
+    }
     fov_settings_type fov_settings;
     fov_settings_init(&fov_settings);
     fov_settings_set_opacity_test_function(&fov_settings, opaque);
     fov_settings_set_apply_lighting_function(&fov_settings, apply);
-    fov_circle(&fov_settings, this, NULL, origin.x(), origin.y(), 100);
+    fov_circle(&fov_settings, this, NULL, origin.x(), origin.y(), fovRadius);
     setSeen(origin);
     fov_settings_free(&fov_settings);
-}
\ No newline at end of file
+}
+
+
+// Symmetric shadowcasting, after Albert Ford's description at
+// https://www.albertford.com/shadowcasting/
+// Each quadrant is scanned row by row outwards from the origin; a floor tile
+// is only lit if its centre lies inside the visible arc, which is what makes
+// the result symmetric: the origin can see a tile exactly when that tile could
+// see the origin. Slopes are kept as fractions to avoid rounding problems.
+namespace {
+    struct Slope {
+        int num, den;
+    };
+
+    struct Row {
+        int depth;
+        Slope start, end;
+    };
+
+    int floorDiv(int a, int b) {
+        int q = a / b;
+        if ((a % b != 0) && ((a < 0) != (b < 0))) --q;
+        return q;
+    }
+
+    int ceilDiv(int a, int b) {
+        return -floorDiv(-a, b);
+    }
+
+    class ShadowCaster {
+    public:
+        ShadowCaster(Board &board, const Point &origin, int quadrant)
+        : board(board), origin(origin), quadrant(quadrant)
+        { }
+
+        void scan(Row firstRow) {
+            std::vector<Row> rows;
+            rows.push_back(firstRow);
+            while (!rows.empty()) {
+                Row row = rows.back();
+                rows.pop_back();
+                if (row.depth > fovRadius) continue;
+
+                // columns from round_ties_up(depth * start) to
+                // round_ties_down(depth * end)
+                const int minCol = floorDiv(2 * row.depth * row.start.num + row.start.den, 2 * row.start.den);
+                const int maxCol = ceilDiv(2 * row.depth * row.end.num - row.end.den, 2 * row.end.den);
+                int prev = tileNone;
+                for (int col = minCol; col <= maxCol; ++col) {
+                    const bool wall = isWall(row.depth, col);
+                    if (wall || isSymmetric(row, col)) reveal(row.depth, col);
+                    if (prev == tileWallish && !wall) {
+                        row.start = slope(row.depth, col);
+                    }
+                    if (prev == tileFloorish && wall) {
+                        Row next = { row.depth + 1, row.start, slope(row.depth, col) };
+                        rows.push_back(next);
+                    }
+                    prev = wall ? tileWallish : tileFloorish;
+                }
+                if (prev == tileFloorish) {
+                    Row next = { row.depth + 1, row.start, row.end };
+                    rows.push_back(next);
+                }
+            }
+        }
+
+    private:
+        static const int tileNone = 0;
+        static const int tileWallish = 1;
+        static const int tileFloorish = 2;
+
+        Point transform(int depth, int col) const {
+            switch(quadrant) {
+                case 0:     return Point(origin.x() + col, origin.y() - depth);
+                case 1:     return Point(origin.x() + col, origin.y() + depth);
+                case 2:     return Point(origin.x() + depth, origin.y() + col);
+                default:    return Point(origin.x() - depth, origin.y() + col);
+            }
+        }
+        bool isWall(int depth, int col) const {
+            const Point p = transform(depth, col);
+            if (!board.valid(p)) return true;
+            return board.isOpaque(p);
+        }
+        bool isSymmetric(const Row &row, int col) const {
+            // start <= col / depth <= end
+            return col * row.start.den >= row.depth * row.start.num
+                && col * row.end.den <= row.depth * row.end.num;
+        }
+        static Slope slope(int depth, int col) {
+            return Slope{ 2 * col - 1, 2 * depth };
+        }
+        void reveal(int depth, int col) {
+            board.setSeen(transform(depth, col));
+        }
+
+        Board &board;
+        Point origin;
+        int quadrant;
+    };
+}
+
+void Board::calcSymmetricFOV(const Point &origin) {
+    setSeen(origin);
+    for (int quadrant = 0; quadrant < 4; ++quadrant) {
+        ShadowCaster caster(*this, origin, quadrant);
+        caster.scan(Row{ 1, Slope{ -1, 1 }, Slope{ 1, 1 } });
+    }
+}
@@ -5,6 +5,8 @@
 #include "command.h"
 #include "config.h"
 #include "gamestate.h"
+#include "gfx_minimap.h"
+#include "gfx_tilelayer.h"
 #include "point.h"
 
 CommandDef commandQuit = { Command::Quit };
@@ -12,11 +14,12 @@ CommandDef commandNone = { Command::None };
 CommandDef commandSpecial = { Command::None };
 
 const CommandDef& getCommand(GameState &system, SDL_Event &event, const CommandDef *commandList) {
-    if (event.type == SDL_USEREVENT) {
-        system.fps = system.timerFrames;
-        system.timerFrames = 0;
-    }
     if (event.type == SDL_QUIT)     return commandQuit;
+    if (event.type == SDL_RENDER_TARGETS_RESET || event.type == SDL_RENDER_DEVICE_RESET) {
+        if (system.atlas) system.buildAtlas();
+        if (system.tileLayer) system.tileLayer->invalidate();
+        if (system.minimap) system.minimap->invalidate();
+    }
     if (event.type == SDL_WINDOWEVENT) {
         if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
             system.config->set("xres", std::to_string(event.window.data1));
@@ -90,6 +93,7 @@ std::ostream& operator<<(std::ostream &out, const Command &cmd) {
         case Command::Run:              out << "run"; break;
         case Command::Interact:         out << "interact"; break;
         case Command::Wait:             out << "wait"; break;
+        case Command::Rest:             out << "rest"; break;
         case Command::ShowMap:          out << "full map"; break;
         case Command::SystemMenu:       out << "system menu"; break;
         case Command::Inventory:        out << "inventory"; break;
@@ -104,6 +108,8 @@ std::ostream& operator<<(std::ostream &out, const Command &cmd) {
         case Command::NextSubweapon:    out << "next subweapon"; break;
         case Command::PrevSubweapon:    out << "prev subweapon"; break;
         case Command::Subweapon:        out << "subweapon"; break;
+        case Command::QuickSave:        out << "quicksave"; break;
+        case Command::QuickLoad:        out << "quickload"; break;
 
         case Command::Debug_Restore:    out << "full restore (debug)"; break;
         case Command::Debug_Reveal:     out << "reveal full map (debug)"; break;
@@ -116,6 +122,8 @@ std::ostream& operator<<(std::ostream &out, const Command &cmd) {
         case Command::Debug_MapEditMode:    out << "map editor mode (debug)"; break;
         case Command::Debug_SelectTile:     out << "map editor mode (debug)"; break;
         case Command::Debug_Teleport:       out << "teleport (debug)"; break;
+        case Command::Debug_Rewind:         out << "rewind turns (debug)"; break;
+        case Command::Debug_Redo:           out << "redo rewound turns (debug)"; break;
         case Command::Debug_SetCursor:      out << "set cursor (debug)"; break;
         case Command::Debug_Fill:           out << "fill region (debug)"; break;
     }
@@ -16,6 +16,7 @@ enum class Command {
     Run,
     Interact,
     Wait,
+    Rest,
     ShowMap,
     SystemMenu,
     Inventory,
@@ -28,6 +29,8 @@ enum class Command {
     NextSubweapon,
     PrevSubweapon,
     Subweapon,
+    QuickSave,
+    QuickLoad,
 
     Debug_Reveal,
     Debug_NoFOV,
@@ -39,6 +42,8 @@ enum class Command {
     Debug_MapEditMode,
     Debug_WarpMap,
     Debug_Teleport,
+    Debug_Rewind,
+    Debug_Redo,
 
     Maped_SetTile,
     Maped_PickTile,
@@ -34,6 +34,7 @@ CommandDef gameCommands[] = {
     { Command::Wait,        Dir::None,  SDLK_PERIOD },
     { Command::Wait,        Dir::None,  SDLK_SPACE },
     { Command::Wait,        Dir::None,  SDLK_KP_PERIOD },
+    { Command::Rest,        Dir::None,  SDLK_r },
 
     { Command::Examine,     Dir::None,  SDLK_x },
     { Command::SelectItem,  Dir::None,  SDLK_RETURN },
@@ -44,11 +45,15 @@ CommandDef gameCommands[] = {
     { Command::NextSubweapon,   Dir::None, SDLK_RIGHTBRACKET },
     { Command::PrevSubweapon,   Dir::None, SDLK_LEFTBRACKET },
     { Command::Subweapon,       Dir::None, SDLK_s },
+    { Command::QuickSave,       Dir::None, SDLK_s, KMOD_LCTRL },
+    { Command::QuickLoad,       Dir::None, SDLK_l, KMOD_LCTRL },
 
     { Command::Debug_Restore, Dir::None, SDLK_F1 },
     { Command::Debug_Reveal,Dir::None,  SDLK_F3 },
     { Command::Debug_NoFOV, Dir::None,  SDLK_F4 },
     { Command::Debug_ShowInfo, Dir::None, SDLK_F5 },
+    { Command::Debug_Rewind,   Dir::None, SDLK_F6 },
+    { Command::Debug_Redo,     Dir::None, SDLK_F6, KMOD_LSHIFT },
     { Command::Debug_ShowFPS,  Dir::None, SDLK_F7 },
     { Command::Debug_TestPathfinder, Dir::None, SDLK_F9 },
     { Command::Debug_WriteMapBinary, Dir::None, SDLK_F10 },
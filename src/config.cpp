@@ -1,12 +1,18 @@
 #include <cstdlib>
 #include <fstream>
 #include <sstream>
+#include "board.h"
 #include "gamestate.h"
 #include "config.h"
 #include "physfs.h"
 #include "logger.h"
+#include "messagelog.h"
 #include "textutil.h"
 
+Config::Config() {
+    parseSettings();
+}
+
 bool Config::loadFromFile(const std::string &file) {
     Logger &log = Logger::getInstance();
     char *buffer = slurpFile(file);
@@ -31,6 +37,7 @@ bool Config::loadFromFile(const std::string &file) {
     }
 
     log.info(std::string("Loaded configuration from ") + file);
+    parseSettings();
     return true;
 }
 
@@ -105,3 +112,40 @@ void Config::set(const std::string &key, const std::string &value) {
 void Config::set(const std::string &key, int value) {
     set(key, std::to_string(value));
 }
+
+void Config::parseSettings() {
+    mSettings.tileScale = getInt("tile_scale", 1);
+    if (mSettings.tileScale < 1) mSettings.tileScale = 1;
+    mSettings.fontScale = getInt("font_scale", 1);
+    if (mSettings.fontScale < 1) mSettings.fontScale = 1;
+    mSettings.animDelay = getInt("anim_delay", 100);
+    if (mSettings.animDelay < 0) mSettings.animDelay = 0;
+    mSettings.messageHistory = getInt("message_history", defaultMessageHistory);
+    if (mSettings.messageHistory < 1) mSettings.messageHistory = 1;
+    if (mSettings.messageHistory > static_cast<int>(maxMessageHistory)) mSettings.messageHistory = maxMessageHistory;
+    mSettings.showRolls = getBool("showrolls", false);
+    mSettings.fullscreen = getBool("fullscreen", false);
+    mSettings.idleRender = getBool("idle_render", true);
+    mSettings.persistentBoards = getBool("persistent_boards", false);
+    mSettings.catchUpTurns = getInt("catchup_turns", defaultCatchUpTurns);
+    if (mSettings.catchUpTurns < 0) mSettings.catchUpTurns = 0;
+    mSettings.fastForwardPreview = getInt("fastforward_preview", 0);
+    if (mSettings.fastForwardPreview < 0) mSettings.fastForwardPreview = 0;
+    mSettings.symmetricFOV = getBool("symmetric_fov", false);
+    mSettings.autosave = getBool("autosave", true);
+    mSettings.journalTurns = getInt("journal_turns", 0);
+    if (mSettings.journalTurns < 0) mSettings.journalTurns = 0;
+}
+
+void Config::addListener(const SettingsListener &listener) {
+    mListeners.push_back(listener);
+}
+
+// Reparse the settings after keys have been changed with set, and let
+// anything that depends on them know.
+void Config::notifyChanged() {
+    parseSettings();
+    for (const SettingsListener &listener : mListeners) {
+        listener(mSettings);
+    }
+}
@@ -1,11 +1,35 @@
 #ifndef CONFIG_H
 #define CONFIG_H
 
+#include <functional>
 #include <map>
 #include <string>
+#include <vector>
+
+// Settings read often enough that they shouldn't be looked up and parsed by
+// name each time. These are parsed from the configuration when it's loaded
+// and again whenever notifyChanged is called.
+struct Settings {
+    int tileScale;
+    int fontScale;
+    int animDelay;
+    int messageHistory;
+    bool showRolls;
+    bool fullscreen;
+    bool idleRender;
+    bool persistentBoards;
+    int catchUpTurns;
+    int fastForwardPreview;
+    bool symmetricFOV;
+    bool autosave;
+    int journalTurns;
+};
+
+typedef std::function<void(const Settings&)> SettingsListener;
 
 class Config {
 public:
+    Config();
     bool loadFromFile(const std::string &file);
     bool writeToFile() const;
     const std::string& getString(const std::string &key, const std::string &defValue) const;
@@ -14,8 +38,18 @@ public:
     bool getBool(const std::string &key, bool defValue) const;
     void set(const std::string &key, const std::string &value);
     void set(const std::string &key, int value);
+
+    const Settings& settings() const {
+        return mSettings;
+    }
+    void addListener(const SettingsListener &listener);
+    void notifyChanged();
 private:
+    void parseSettings();
+
     std::map<std::string, std::string> mKeys;
+    Settings mSettings;
+    std::vector<SettingsListener> mListeners;
 };
 
 
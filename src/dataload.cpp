@@ -14,8 +14,14 @@
 #include "physfs.h"
 #include "logger.h"
 #include "textutil.h"
+#include "game.h"
 #include "gamestate.h"
+#include "gfx_atlas.h"
+#include "gfx_minimap.h"
+#include "gfx_tilelayer.h"
+#include "loader.h"
 #include "physfsrwops.h"
+#include "workerpool.h"
 
 
 static bool fileHasExtension(const std::string &filename, const std::vector<std::string> &list) {
@@ -51,20 +57,15 @@ char* slurpFile(const std::string &filename) {
     return buffer;
 }
 
-bool GameState::load() {
+// Load the game data file and start decoding images and audio in the
+// background. The rest of the loading is done by finishLoad once decoding
+// completes; until then, pollLoading should be called regularly.
+bool GameState::beginLoad() {
     Logger &log = Logger::getInstance();
 
     try {
         if (!vm->loadFromFile("game.dat", true))    return false;
-        if (!loadAudioTracks())                     return false;
-        if (!loadActorData())                       return false;
-        if (!loadItemDefs())                        return false;
-        if (!loadLocationsData())                   return false;
-        if (!loadLootTables())                      return false;
-        if (!loadMapInfoData())                     return false;
         if (!loadMusicTracks())                     return false;
-        if (!loadTileData())                        return false;
-        if (!loadWorldData())                       return false;
 
         gameName = vm->readString(vm->readWord(4));
         gameId = vm->readWord(8);
@@ -75,6 +76,61 @@ bool GameState::load() {
         return false;
     }
 
+    mLoader = new AssetLoader;
+    queueAssets();
+    mLoader->start();
+    return true;
+}
+
+void GameState::queueAssets() {
+    static const char *imageDirs[] = { "/gfx/actors", "/gfx/items", "/gfx/tiles", nullptr };
+    for (int i = 0; imageDirs[i]; ++i) {
+        char **files = PHYSFS_enumerateFiles(imageDirs[i]);
+        for (char **iter = files; *iter != nullptr; ++iter) {
+            std::string filename = std::string(imageDirs[i]) + "/" + *iter;
+            if (fileHasExtension(filename, {".png"})) mLoader->addImage(filename);
+        }
+        PHYSFS_freeList(files);
+    }
+    for (const std::string &name : readManifest("/gfx/preload.txt")) {
+        mLoader->addImage("/gfx/" + name);
+    }
+
+    char **audioEffects = PHYSFS_enumerateFiles("/audio");
+    for (char **iter = audioEffects; *iter != nullptr; ++iter) {
+        std::string filename = *iter;
+        if (fileHasExtension(filename, {".ogg"})) mLoader->addAudio("/audio/" + filename);
+    }
+    PHYSFS_freeList(audioEffects);
+}
+
+bool GameState::finishLoad() {
+    Logger &log = Logger::getInstance();
+    mLoader->wait();
+    mLoader->logErrors();
+
+    bool success = true;
+    try {
+        success = loadAudioTracks()
+                && loadActorData()
+                && loadItemDefs()
+                && loadLocationsData()
+                && loadLootTables()
+                && loadMapInfoData()
+                && loadTileData()
+                && loadWorldData()
+                && preloadImages("/gfx/preload.txt");
+    } catch (VMError &e) {
+        log.error(e.what());
+        success = false;
+    }
+
+    // frees anything decoded that wasn't used
+    delete mLoader;
+    mLoader = nullptr;
+    if (!success) return false;
+    buildAtlas();
+
     subweapons.push_back(Subweapon{ "bow",      "ui/bow.png",      true });
     subweapons.push_back(Subweapon{ "hookshot", "ui/hookshot.png", true });
     subweapons.push_back(Subweapon{ "bomb",     "ui/bomb.png",     true });
@@ -84,6 +140,30 @@ bool GameState::load() {
     return true;
 }
 
+void GameState::pollLoading() {
+    if (mLoader && mLoader->isDone()) finishLoading();
+}
+
+void GameState::finishLoading() {
+    if (!mLoader) return;
+    if (!finishLoad()) {
+        throw GameError("Failed to load game data.");
+    }
+}
+
+bool GameState::isLoading() const {
+    return mLoader != nullptr;
+}
+
+void GameState::getLoadProgress(int &done, int &total) const {
+    if (!mLoader) {
+        done = total = 0;
+        return;
+    }
+    done = mLoader->completed();
+    total = mLoader->total();
+}
+
 bool GameState::loadMusicTracks() {
     Logger &log = Logger::getInstance();
     char **musicTracks = PHYSFS_enumerateFiles("/music");
@@ -211,7 +291,7 @@ bool GameState::loadActorData() {
         type.moveRate  = vm->readWord(npcTypesAddr + counter * npcTypeSize + 32);
         type.lootType  = vm->readWord(npcTypesAddr + counter * npcTypeSize + 36);
         type.loot      = vm->readWord(npcTypesAddr + counter * npcTypeSize + 40);
-        if (!type.artFile.empty()) type.art = getImage("actors/" + type.artFile + ".png");
+        if (!type.artFile.empty()) type.art = holdDataImage("actors/" + type.artFile + ".png");
         ActorType::add(type);
     }
     log.info(std::string("Loaded ") + std::to_string(ActorType::typeCount()) + " npc types.");
@@ -235,7 +315,7 @@ bool GameState::loadItemDefs() {
         itemDef.itemId = vm->readWord(itemdefsAddr + counter * itemdefSize + 8);
         if (nameStrAddr) itemDef.name    = vm->readString(nameStrAddr);
         if (artStrAddr)  itemDef.artFile = vm->readString(artStrAddr);
-        if (!itemDef.artFile.empty()) itemDef.art = getImage("items/" + itemDef.artFile + ".png");
+        if (!itemDef.artFile.empty()) itemDef.art = holdDataImage("items/" + itemDef.artFile + ".png");
         else itemDef.art = nullptr;
         itemDefs.push_back(itemDef);
     }
@@ -313,10 +393,10 @@ bool GameState::loadTileData() {
         if (!tile.artFile.empty()) {
             if (tile.animLength > 1) {
                 for (int i = 1; i <= tile.animLength; ++i) {
-                    tile.frames.push_back(getImage("tiles/" + tile.artFile + std::to_string(i) + ".png"));
+                    tile.frames.push_back(holdDataImage("tiles/" + tile.artFile + std::to_string(i) + ".png"));
                 }
             } else {
-                tile.art = getImage("tiles/" + tile.artFile + ".png");
+                tile.art = holdDataImage("tiles/" + tile.artFile + ".png");
             }
         }
         TileInfo::add(tile);
@@ -351,14 +431,29 @@ bool GameState::loadWorldData() {
 }
 
 void GameState::unloadAll() {
+    delete mLoader;
+    mLoader = nullptr;
+    delete tileLayer;
+    tileLayer = nullptr;
+    delete atlas;
+    atlas = nullptr;
+    delete minimap;
+    minimap = nullptr;
+    delete workers;
+    workers = nullptr;
     for (auto iter : mTiles)          SDL_DestroyTexture(iter.second);
-    for (auto iter : mImages)         SDL_DestroyTexture(iter.second);
+    for (ImageHandle handle : mDataImages) releaseImage(handle);
+    mDataImages.clear();
+    logAssetStats();
+    for (auto iter : mImageAssets)    if (iter.texture) SDL_DestroyTexture(iter.texture);
     for (auto iter : mAudio)          Mix_FreeChunk(iter.second);
     for (auto iter : mFonts)          delete iter.second;
     if (mCurrentMusic)                Mix_FreeMusic(mCurrentMusic);
 
     mTiles.clear();
     mImages.clear();
+    mImageAssets.clear();
+    mAssetStats.residentBytes = 0;
     mAudio.clear();
     mFonts.clear();
     mCurrentMusic = nullptr;
@@ -0,0 +1,55 @@
+#include <algorithm>
+#include <cmath>
+
+#include "framestats.h"
+
+FrameStats::FrameStats()
+: mNext(0), mCount(0)
+{ }
+
+void FrameStats::clear() {
+    mNext = mCount = 0;
+}
+
+void FrameStats::add(double ms) {
+    mTimes[mNext] = ms;
+    mNext = (mNext + 1) % frameHistory;
+    if (mCount < frameHistory) ++mCount;
+}
+
+unsigned FrameStats::size() const {
+    return mCount;
+}
+
+// Index 0 is the oldest frame held.
+double FrameStats::at(unsigned index) const {
+    return mTimes[(mNext + frameHistory - mCount + index) % frameHistory];
+}
+
+FrameSummary FrameStats::summarize() const {
+    mSorted.clear();
+    for (unsigned i = 0; i < mCount; ++i) mSorted.push_back(at(i));
+    return summarizeFrameTimes(mSorted);
+}
+
+// Sorts times in place. Percentiles use the nearest rank method.
+FrameSummary summarizeFrameTimes(std::vector<double> &times) {
+    FrameSummary summary = { static_cast<unsigned>(times.size()), 0, 0, 0, 0, 0, 0 };
+    if (times.empty()) return summary;
+
+    std::sort(times.begin(), times.end());
+    auto percentile = [&times](double p) {
+        int rank = std::ceil(p * times.size()) - 1;
+        if (rank < 0) rank = 0;
+        return times[rank];
+    };
+    double total = 0;
+    for (double time : times) total += time;
+    summary.mean = total / times.size();
+    summary.min = times.front();
+    summary.max = times.back();
+    summary.p50 = percentile(0.50);
+    summary.p95 = percentile(0.95);
+    summary.p99 = percentile(0.99);
+    return summary;
+}
@@ -0,0 +1,32 @@
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <vector>
+
+const unsigned frameHistory = 240;
+
+struct FrameSummary {
+    unsigned count;
+    double mean, min, max, p50, p95, p99;
+};
+
+FrameSummary summarizeFrameTimes(std::vector<double> &times);
+
+// Durations of the most recent frames, in milliseconds.
+class FrameStats {
+public:
+    FrameStats();
+
+    void clear();
+    void add(double ms);
+    unsigned size() const;
+    double at(unsigned index) const;
+    FrameSummary summarize() const;
+
+private:
+    double mTimes[frameHistory];
+    unsigned mNext, mCount;
+    mutable std::vector<double> mSorted;
+};
+
+#endif
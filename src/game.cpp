@@ -1,3 +1,4 @@
+#include <cstdlib>
 #include <ctime>
 #include <fstream>
 #include <sstream>
@@ -9,24 +10,18 @@
 
 #include "physfs.h"
 
+#include "benchmark.h"
 #include "game.h"
 #include "gamestate.h"
 #include "vm.h"
 #include "random.h"
+#include "replay.h"
 #include "config.h"
 #include "logger.h"
+#include "textutil.h"
 
 bool printVersions();
-int innerMain(GameState &gameState);
-
-unsigned perSecondTimer(unsigned interval, void *param) {
-    SDL_Event event;
-    event.type = SDL_USEREVENT;
-    event.user.type = SDL_USEREVENT;
-    SDL_PushEvent(&event);
-    return(interval);
-}
-
+int innerMain(GameState &gameState, const BenchmarkOptions *benchmark, const Recording *replay);
 
 std::string versionString() {
     std::string text = GAME_NAME;
@@ -40,6 +35,40 @@ std::string versionString() {
 }
 
 int main(int argc, char *argv[]) {
+    bool doBenchmark = false;
+    BenchmarkOptions benchmark = { 600, 0 };
+    bool hasSeed = false;
+    unsigned long long seed = 0;
+    std::string recordFile, replayFile;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-benchmark") {
+            doBenchmark = true;
+        } else if (arg == "-frames" && i + 1 < argc) {
+            benchmark.frames = strToInt(argv[++i]);
+        } else if (arg == "-map" && i + 1 < argc) {
+            benchmark.mapIndex = strToInt(argv[++i]);
+        } else if (arg == "-seed" && i + 1 < argc) {
+            seed = std::strtoull(argv[++i], nullptr, 10);
+            hasSeed = true;
+        } else if (arg == "-record" && i + 1 < argc) {
+            recordFile = argv[++i];
+        } else if (arg == "-replay" && i + 1 < argc) {
+            replayFile = argv[++i];
+        } else {
+            std::cerr << "Unknown argument " << arg << "\n";
+            std::cerr << "usage: " << argv[0] << " [-seed value] [-record file] [-replay file] [-benchmark [-frames count] [-map index]]\n";
+            return 1;
+        }
+    }
+    const bool headless = doBenchmark || !replayFile.empty();
+    if (headless) {
+        // run without a display or sound device; these can still be
+        // overridden through the environment
+        SDL_setenv("SDL_VIDEODRIVER", "dummy", 0);
+        SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    }
+
     if (!PHYSFS_init(argv[0])) {
         auto err = PHYSFS_getLastErrorCode();
         std::cerr << "Failed to initialize PHYSFS:" << PHYSFS_getErrorByCode(err) << "\n";
@@ -77,6 +106,11 @@ int main(int argc, char *argv[]) {
     unsigned windowFlags = SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE;
     if (config.getBool("fullscreen", false)) windowFlags |= SDL_WINDOW_FULLSCREEN_DESKTOP;
     if (config.getBool("maximized", false))  windowFlags |= SDL_WINDOW_MAXIMIZED;
+    if (headless) {
+        initialXRes = benchmarkWidth;
+        initialYRes = benchmarkHeight;
+        windowFlags = SDL_WINDOW_HIDDEN;
+    }
     SDL_Window *win = SDL_CreateWindow(GAME_NAME,
                                        SDL_WINDOWPOS_CENTERED_DISPLAY(displayNum),
                                        SDL_WINDOWPOS_CENTERED_DISPLAY(displayNum),
@@ -92,6 +126,7 @@ int main(int argc, char *argv[]) {
     if (config.getBool("vsync", true)) {
         rendererFlags |= SDL_RENDERER_PRESENTVSYNC;
     }
+    if (headless) rendererFlags = SDL_RENDERER_SOFTWARE;
     SDL_Renderer *renderer = SDL_CreateRenderer(win, -1, rendererFlags);
     if (renderer == nullptr){
         log.error(std::string("SDL_CreateRenderer Error: ") + SDL_GetError());
@@ -127,15 +162,23 @@ int main(int argc, char *argv[]) {
     Mix_VolumeMusic(config.getInt("music", MIX_MAX_VOLUME));
     Mix_Volume(-1, config.getInt("audio", MIX_MAX_VOLUME));
 
-    SDL_AddTimer(1000, perSecondTimer, nullptr);
-
+    // benchmarks use a fixed seed unless given one so that runs are comparable
+    if (!hasSeed) seed = doBenchmark ? benchmarkSeed : time(0);
     Random coreRandom;
-    coreRandom.seed(time(0));
+    coreRandom.seed(seed);
+    log.info("Random seed is " + std::to_string(seed));
     GameState gameState(renderer, coreRandom);
     gameState.window = win;
     gameState.config = &config;
-    int returnCode = innerMain(gameState);
-    config.writeToFile();
+    Recording recording(recordFile);
+    if (!recordFile.empty()) gameState.recording = &recording;
+    Recording replay(replayFile);
+    int returnCode = 1;
+    if (replayFile.empty() || replay.load()) {
+        returnCode = innerMain(gameState, doBenchmark ? &benchmark : nullptr,
+                               replayFile.empty() ? nullptr : &replay);
+    }
+    if (!headless) config.writeToFile();
     log.endLog();
 
     Mix_CloseAudio();
@@ -194,7 +237,7 @@ bool printVersions() {
     return true;
 }
 
-int innerMain(GameState &gameState) {
+int innerMain(GameState &gameState, const BenchmarkOptions *benchmark, const Recording *replay) {
 
     VM vm;
     gameState.vm = &vm;
@@ -208,13 +251,18 @@ int innerMain(GameState &gameState) {
     if (!gameState.tinyFont) return 1;
     gameState.tinyFont->setMetrics(9, 18, 1);
 
-    if (!gameState.load()) {
+    if (!gameState.beginLoad()) {
         Logger &log = Logger::getInstance();
         log.error("Fatal error: failed to load game data.");
         return 1;
     }
 
-    gameState.setFontScale(gameState.config->getInt("font_scale", 1));
+    gameState.applySettings(gameState.config->settings());
+    gameState.config->addListener([&gameState](const Settings &settings) {
+        gameState.applySettings(settings);
+    });
+    if (benchmark) return runBenchmark(gameState, *benchmark);
+    if (replay) return runReplay(gameState, *replay);
 
     try {
         doGameMenu(gameState);
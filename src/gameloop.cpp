@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
 #include <memory>
@@ -15,6 +16,8 @@
 #include "vm.h"
 #include "random.h"
 #include "gamestate.h"
+#include "replay.h"
+#include "savegame.h"
 #include "textutil.h"
 
 struct ProjectileInfo {
@@ -32,10 +35,16 @@ void mapedloop(GameState &state);
 
 bool basicProjectileAttack(GameState &state, const ProjectileInfo &projectile, Dir d);
 void doPlayerMove(GameState &state, Dir dir, bool forRun);
+int fastForward(GameState &state, bool resting, int maxTurns = -1);
 void doMeleeAttack(GameState &state, Actor *actor);
 bool tryInteract(GameState &state, Dir d, const Point &target);
 
 
+// resting stops after this many turns even if nothing interrupts it; while
+// running or resting, input is checked every fastForwardPollTime ms
+const int maxRestTurns = 100;
+const unsigned fastForwardPollTime = 50;
+
 const int projArrow = 0;
 const int projFireBolt = 1;
 const int projIceBolt = 2;
@@ -70,18 +79,25 @@ bool basicProjectileAttack(GameState &state, const ProjectileInfo &projectile, D
         texProj = state.getImage("effects/" + projectile.filename + ".png");
     }
 
-    std::vector<AnimFrame> frames;
+    // the projectile takes one step per tile travelled; everything else
+    // happens as it arrives
+    Timeline &timeline = state.animations;
+    const unsigned step = state.animationDelay();
+    const unsigned start = timeline.now();
+    unsigned steps = 0;
     Point initial = state.getPlayer()->position;
     Point work(initial);
     while (1) {
-        work = work.shift(d);
-        if (!board->valid(work)) break;
-        const TileInfo &tileInfo = TileInfo::get(board->getTile(work));
+        Point next = work.shift(d);
+        if (!board->valid(next)) break;
+        const TileInfo &tileInfo = TileInfo::get(board->getTile(next));
         if (tileInfo.flags & TF_SOLID) {
-            frames.push_back(AnimFrame(animText, "Your " + projectile.name + " hits the " + tileInfo.name + "."));
-            state.queueFrames(frames);
+            if (steps > 0) timeline.addMotion(start, steps * step, initial, work, texProj);
+            timeline.addText(start + steps * step, animText, "Your " + projectile.name + " hits the " + tileInfo.name + ".");
             return false;
         }
+        work = next;
+        ++steps;
 
         actor = board->actorAt(work);
         if (actor) {
@@ -90,29 +106,26 @@ bool basicProjectileAttack(GameState &state, const ProjectileInfo &projectile, D
                 isHit = doAccuracyCheck(state, state.getPlayer(), actor, 0);
             }
             if (!isHit) {
-                frames.push_back(AnimFrame(animText, "Your " + projectile.name + " misses " + actor->getName() + "."));
+                timeline.addText(start + steps * step, animText, "Your " + projectile.name + " misses " + actor->getName() + ".");
                 actor = nullptr;
             }
             else break;
         }
-
-        frames.push_back(AnimFrame(work, texProj));
     }
+    if (steps > 0) timeline.addMotion(start, steps * step, initial, work, texProj);
 
     if (actor) {
         int d = projectile.damageDice;
         if (d <= 0) d = state.subweaponLevel[SW_BOW];
-        int damage = state.coreRNG.roll(d, projectile.damageSides);
-        if (state.config->getBool("showrolls", false)) {
+        int damage = state.combatRNG.roll(d, projectile.damageSides);
+        if (state.config->settings().showRolls) {
             std::stringstream msg;
             msg << "[damage: " << d << 'd' << projectile.damageSides << '=' << damage << ']';
-            frames.push_back(AnimFrame(animRollText, msg.str()));
+            timeline.addText(start + steps * step, animRollText, msg.str());
         }
         SDL_Texture *texSplat = state.getImage("effects/splat.png");
-        frames.push_back(AnimFrame(work, texSplat));
-        frames.push_back(AnimFrame(actor, damage, 0, "your " + projectile.name));
-
-        state.queueFrames(frames);
+        timeline.addSprite(start + steps * step, step, work, texSplat);
+        timeline.addDamage(start + (steps + 1) * step, actor, damage, 0, "your " + projectile.name);
         return true;
     }
     return false;
@@ -142,12 +155,106 @@ void doPlayerMove(GameState &state, Dir dir, bool forRun) {
     }
 }
 
+static void findVisibleEnemies(Board *board, std::vector<const Actor*> &enemies) {
+    enemies.clear();
+    for (const Actor *actor : board->getActors()) {
+        if (actor->typeInfo->aiType != aiEnemy || actor->curHealth <= 0) continue;
+        if (board->isVisible(actor->position)) enemies.push_back(actor);
+    }
+}
+
+// Run (in state.runDirection) or rest, simulating turns back to back without
+// drawing them. This continues until something interrupts: an enemy comes
+// into view, the player is hurt, an item or event is reached, the run crosses
+// into a different group of tiles, or a key is pressed. Animations are
+// finished immediately so that their effects land on the turn they belong to.
+// If fastforward_preview is set, the map is redrawn at most that often.
+// Returns the number of turns taken; replays pass that back in as maxTurns
+// in place of the key press.
+int fastForward(GameState &state, bool resting, int maxTurns) {
+    Board *board = state.getBoard();
+    Actor *player = state.getPlayer();
+    if (!state.animations.empty()) state.animations.finish(state);
+
+    std::vector<const Actor*> knownEnemies, visibleEnemies;
+    findVisibleEnemies(board, knownEnemies);
+    if (resting && !knownEnemies.empty()) {
+        state.addMessage("You can't rest with enemies in view.");
+        return 0;
+    }
+    const bool wasHurt = player->curHealth < player->typeInfo->maxHealth
+                      || player->curEnergy < player->typeInfo->maxEnergy;
+    if (resting && !wasHurt) {
+        state.addMessage("You're already fully rested.");
+        return 0;
+    }
+    const Point initialTilePos = player->position.shift(state.runDirection, 1);
+    const int initialGroup = TileInfo::get(board->getTile(initialTilePos)).group;
+
+    const unsigned previewTime = state.config->settings().fastForwardPreview;
+    unsigned lastPreview = SDL_GetTicks();
+    unsigned lastPoll = lastPreview;
+    int turns = 0;
+    while (!state.wantsToQuit) {
+        if (resting) {
+            if (turns >= maxRestTurns) break;
+            if (player->curHealth >= player->typeInfo->maxHealth
+                        && player->curEnergy >= player->typeInfo->maxEnergy) break;
+            state.requestTick();
+        } else {
+            if (state.runDirection == Dir::None) break;
+            const Point dest = player->position.shift(state.runDirection);
+            const bool stopAfter = board->valid(dest) && (board->itemAt(dest) || board->eventAt(dest));
+            doPlayerMove(state, state.runDirection, true);
+            if (state.getBoard() != board) break;
+            if (stopAfter) state.runDirection = Dir::None;
+            const TileInfo &thisTile = TileInfo::get(board->getTile(player->position));
+            if (initialGroup != thisTile.group) state.runDirection = Dir::None;
+        }
+        if (!state.hasTick()) break;
+
+        const int health = player->curHealth;
+        state.tick();
+        if (!state.animations.empty()) state.animations.finish(state);
+        ++turns;
+        if (state.getBoard() != board || board->getPlayer() != player) break;
+        if (player->curHealth < health) break;
+        findVisibleEnemies(board, visibleEnemies);
+        bool newEnemy = false;
+        for (const Actor *enemy : visibleEnemies) {
+            if (std::find(knownEnemies.begin(), knownEnemies.end(), enemy) == knownEnemies.end()) {
+                newEnemy = true;
+                break;
+            }
+        }
+        if (newEnemy) {
+            state.addMessage("You see an enemy.");
+            break;
+        }
+        if (maxTurns >= 0 && turns >= maxTurns) break;
+        if (state.replaying) continue;
+
+        const unsigned now = SDL_GetTicks();
+        if (previewTime > 0 && now - lastPreview >= previewTime) {
+            repaint(state);
+            lastPreview = now;
+        }
+        if (now - lastPoll >= fastForwardPollTime) {
+            if (passCommand(state)) break;
+            lastPoll = now;
+        }
+    }
+    state.runDirection = Dir::None;
+    if (resting) state.addMessage("You rest for " + std::to_string(turns) + " turns.");
+    return turns;
+}
+
 Dir gfx_GetDirection(GameState &system, const std::string &prompt, bool allowHere) {
     system.addMessage(prompt + "; which way?");
     while (1) {
         repaint(system);
         SDL_Event event;
-        while (SDL_PollEvent(&event)) {
+        while (system.nextEvent(event)) {
             const CommandDef &cmd = getCommand(system, event, gameCommands);
             switch(cmd.command) {
                 case Command::Move:
@@ -183,7 +290,7 @@ Point gfx_SelectTile(GameState &system, const std::string &prompt) {
         system.replaceMessage(line.str());
         repaint(system);
         SDL_Event event;
-        while (SDL_PollEvent(&event)) {
+        while (system.nextEvent(event)) {
             const CommandDef &cmd = getCommand(system, event, gameCommands);
             switch(cmd.command) {
                 case Command::Move: {
@@ -219,8 +326,8 @@ void doMeleeAttack(GameState &state, Actor *actor) {
     } else {
         int roll = 1;
         if (state.swordLevel > 0) {
-            roll = state.coreRNG.roll(state.swordLevel, 4);
-            if (state.config->getBool("showrolls", false)) {
+            roll = state.combatRNG.roll(state.swordLevel, 4);
+            if (state.config->settings().showRolls) {
                 std::stringstream msg2;
                 msg2 << "[damage: " << state.swordLevel << 'd' << 4 << '=' << roll << ']';
                 state.addInfo(msg2.str());
@@ -228,7 +335,7 @@ void doMeleeAttack(GameState &state, Actor *actor) {
         }
         state.getBoard()->doDamage(state, actor, roll, 0, "your attack");
         SDL_Texture *texSplat = state.getImage("effects/splat.png");
-        state.queueFrame(AnimFrame(actor->position, texSplat));
+        state.animations.addSprite(state.animations.now(), state.animationDelay(), actor->position, texSplat);
     }
 }
 
@@ -247,8 +354,8 @@ bool tryInteract(GameState &state, Dir d, const Point &target) {
         } else if (actor->typeInfo->aiType == aiBreakable) {
             doMeleeAttack(state, actor);
         } else {
-            if (actor->talkFunc) state.vm->run(actor->talkFunc);
-            else                 state.addMessage(upperFirst(actor->getName()) + " has nothing to say.");
+            if (actor->details->talkFunc) state.vm->run(actor->details->talkFunc);
+            else                          state.addMessage(upperFirst(actor->getName()) + " has nothing to say.");
         }
         state.requestTick();
         return true;
@@ -281,54 +388,209 @@ void gameloop(GameState &state) {
     state.getBoard()->calcFOV(state.getPlayer()->position);
 
     state.runDirection = Dir::None;
-    state.lastticks = SDL_GetTicks();
+    state.resetFrameTimer();
 
+    const Board *lastBoard = state.getBoard();
     while (!state.wantsToQuit && !state.returnToMenu) {
-        if (state.runDirection != Dir::None) {
-            const Point initalTilePos = state.getPlayer()->position.shift(state.runDirection, 1);
-            const TileInfo &initialTile = TileInfo::get(state.getBoard()->getTile(initalTilePos));
-            do {
-                doPlayerMove(state, state.runDirection, true);
-                if (state.runDirection != Dir::None) {
-                    const TileInfo &thisTile = TileInfo::get(state.getBoard()->getTile(state.getPlayer()->position));
-                    if (initialTile.group != thisTile.group) {
-                        state.runDirection = Dir::None;
-                    }
-                }
-                if (state.hasTick()) {
-                    state.tick();
-                    repaint(state);
-                    if (passCommand(state)) state.runDirection = Dir::None;
-                }
-            } while (state.runDirection != Dir::None && !state.wantsToQuit);
-            continue;
-        }
-
-        while (!state.animationQueue.empty()) {
-            if (repaint(state)) {
-                SDL_Delay(200);
-                SDL_PumpEvents();
-            }
+        // the rest of the turn waits until any animations (and the damage
+        // they carry) have played out
+        if (state.hasTick() && state.animations.empty()) state.tick();
+        if (state.getBoard() != lastBoard && !state.hasTick() && state.animations.empty()) {
+            lastBoard = state.getBoard();
+            if (state.config->settings().autosave) saveGame(state, autosaveFile);
         }
-        if (state.hasTick()) state.tick();
         repaint(state);
 
         gfx_handleInput(state);
         if (state.wantsToQuit) {
-            if (!gfx_Confirm(state, "Are you sure you want to quit?", "Your progress will NOT be saved.")) {
+            const bool autosave = state.config->settings().autosave;
+            if (!gfx_Confirm(state, "Are you sure you want to quit?",
+                             autosave ? "Your progress will be autosaved."
+                                      : "Progress since your last save will be lost.")) {
                 state.wantsToQuit = false;
             } else {
+                if (autosave) {
+                    // let the last turn finish so the save doesn't catch it halfway
+                    if (!state.animations.empty()) state.animations.finish(state);
+                    if (state.hasTick()) state.tick();
+                    saveGame(state, autosaveFile);
+                }
                 state.gameInProgress = false;
             }
         }
     }
 
+    if (state.recording) state.recording->save();
+}
+
+
+// Carry out an action whose prompts have all been answered. Runs and rests
+// record how many turns they took in action.arg1.
+void performAction(GameState &state, PlayerAction &action) {
+    switch(action.command) {
+        case Command::Move:
+            doPlayerMove(state, action.direction, false);
+            break;
+        case Command::Run:
+            state.runDirection = action.direction;
+            action.arg1 = fastForward(state, false, action.arg1);
+            break;
+        case Command::Interact: {
+            Point target = state.getPlayer()->position.shift(action.direction, 1);
+            if (!tryInteract(state, action.direction, target)) {
+                state.addMessage("Nothing to do!");
+            }
+            break; }
+        case Command::Wait:
+            state.requestTick();
+            break;
+        case Command::Rest:
+            action.arg1 = fastForward(state, true, action.arg1);
+            break;
+
+        case Command::NextSubweapon: {
+            bool hasSubweapon = false;
+            for (int i = 0; i < SW_COUNT; ++i) {
+                if (state.subweaponLevel[i] > 0) {
+                    hasSubweapon = true;
+                    break;
+                }
+            }
+            if (!hasSubweapon) {
+                state.currentSubweapon = -1;
+            } else {
+                do {
+                    ++state.currentSubweapon;
+                    if (state.currentSubweapon >= SW_COUNT) state.currentSubweapon = 0;
+                } while (state.subweaponLevel[state.currentSubweapon] == 0);
+            }
+            break; }
+        case Command::PrevSubweapon: {
+            bool hasSubweapon = false;
+            for (int i = 0; i < SW_COUNT; ++i) {
+                if (state.subweaponLevel[i] > 0) {
+                    hasSubweapon = true;
+                    break;
+                }
+            }
+            if (!hasSubweapon) {
+                state.currentSubweapon = -1;
+            } else {
+                do {
+                    --state.currentSubweapon;
+                    if (state.currentSubweapon < 0) state.currentSubweapon = SW_COUNT - 1;
+                } while (state.subweaponLevel[state.currentSubweapon] == 0);
+            }
+            break; }
+        case Command::Subweapon: {
+            if (state.currentSubweapon < 0) break;
+            const Dir d = action.direction;
+            switch(state.currentSubweapon) {
+                case SW_BOW:
+                    if (state.arrowCount <= 0) {
+                        state.addMessage("Out of ammo!");
+                        break;
+                    }
+                    --state.arrowCount;
+                    state.requestTick();
+                    basicProjectileAttack(state, projectiles[projArrow], d);
+                    break;
+                case SW_FIREROD:
+                    if (state.getPlayer()->curEnergy < 3) {
+                        state.addMessage("Out of energy!");
+                        break;
+                    }
+                    state.getPlayer()->curEnergy -= 3;
+                    state.requestTick();
+                    basicProjectileAttack(state, projectiles[projFireBolt], d);
+                    break;
+                case SW_ICEROD:
+                    if (state.getPlayer()->curEnergy < 3) {
+                        state.addMessage("Out of energy!");
+                        break;
+                    }
+                    state.getPlayer()->curEnergy -= 3;
+                    state.requestTick();
+                    basicProjectileAttack(state, projectiles[projIceBolt], d);
+                    break;
+                case SW_PICKAXE: {
+                    Actor *actor = state.getBoard()->actorAt(state.getPlayer()->position.shift(d));
+                    if (actor) {
+                        state.requestTick();
+                        bool isHit = doAccuracyCheck(state, state.getPlayer(), actor, -2);
+                        if (!isHit) {
+                            state.addMessage("You miss " + actor->getName() + ".");
+                        } else {
+                            int roll = state.combatRNG.roll(3, 4);
+                            if (state.config->settings().showRolls) {
+                                std::stringstream msg2;
+                                msg2 << "[damage: 3d4" << '=' << roll << ']';
+                                state.addInfo(msg2.str());
+                            }
+                            state.getBoard()->doDamage(state, actor, roll, 0, "your pickaxe");
+                        }
+                    } else {
+                        state.addMessage("Your pickaxe has no impact.");
+                    }
+                    break; }
+                case SW_BOMB: {
+                    if (state.bombCount <= 0) {
+                        state.addMessage("You don't have any bombs.");
+                        break;
+                    }
+                    Point dest = state.getPlayer()->position.shift(d);
+                    const TileInfo &tileInfo = TileInfo::get(state.getBoard()->getTile(dest));
+                    Actor *existing = state.getBoard()->actorAt(dest);
+                    if (tileInfo.flags & TF_SOLID || existing) {
+                        state.addMessage("There's no space.");
+                    } else {
+                        --state.bombCount;
+                        if (state.bombCount <= 0) state.subweaponLevel[SW_BOMB] = 0;
+                        Actor *bomb = state.getBoard()->createActor(1, dest);
+                        bomb->reset();
+                        bomb->ai_pathNext = 5;
+                    }
+                    break; }
+                default:
+                    state.addError("The " + state.subweapons[state.currentSubweapon].name + " is not implemented.");
+            }
+            break; }
+
+        case Command::Debug_WarpMap: {
+            Point position = state.getPlayer()->position;
+            state.warpTo(action.arg1, position.x(), position.y());
+            break; }
+        case Command::Debug_Teleport:
+            state.warpTo(-1, action.arg1, action.arg2);
+            break;
+        case Command::Debug_Restore:
+            state.getPlayer()->curHealth = state.getPlayer()->typeInfo->maxHealth;
+            state.getPlayer()->curEnergy = state.getPlayer()->typeInfo->maxEnergy;
+            state.bombCount = state.bombCapacity;
+            state.arrowCount = state.arrowCapacity;
+            break;
+        default:
+            /* everything else is handled by gfx_handleInput */
+            break;
+    }
 }
 
+// Actions go into the recording after they are carried out, as only then is
+// the length of a run or rest known.
+static void takeAction(GameState &state, PlayerAction action) {
+    performAction(state, action);
+    if (state.recording) state.recording->add(action);
+}
 
 void gfx_handleInput(GameState &state) {
     SDL_Event event;
-    while (SDL_PollEvent(&event)) {
+    while (state.nextEvent(event)) {
+        // a key press skips any animations still playing and finishes the
+        // turn before acting on the key
+        if (event.type == SDL_KEYDOWN) {
+            if (!state.animations.empty()) state.animations.finish(state);
+            if (state.hasTick()) state.tick();
+        }
         const CommandDef &cmd = getCommand(state, event, gameCommands);
         switch(cmd.command) {
             case Command::None:
@@ -342,32 +604,32 @@ void gfx_handleInput(GameState &state) {
                 state.wantsToQuit = true;
                 break;
 
-            case Command::Move: {
-                doPlayerMove(state, cmd.direction, false);
-                break; }
+            case Command::Move:
+            case Command::Wait:
+            case Command::NextSubweapon:
+            case Command::PrevSubweapon:
+            case Command::Debug_Restore:
+                takeAction(state, PlayerAction{cmd.command, cmd.direction, 0, 0});
+                break;
+            case Command::Rest:
+                takeAction(state, PlayerAction{cmd.command, Dir::None, -1, 0});
+                break;
             case Command::Run: {
                 Dir d = cmd.direction;
                 if (d == Dir::None) {
                     d = gfx_GetDirection(state, "Run");
                     if (d == Dir::None) break;
                 }
-                state.runDirection = d;
+                takeAction(state, PlayerAction{cmd.command, d, -1, 0});
                 break; }
-
             case Command::Interact: {
                 Dir d = cmd.direction;
                 if (d == Dir::None) {
                     d = gfx_GetDirection(state, "Activate", true);
                     if (d == Dir::None) break;
                 }
-                Point target = state.getPlayer()->position.shift(d, 1);
-                if (!tryInteract(state, d, target)) {
-                    state.addMessage("Nothing to do!");
-                }
+                takeAction(state, PlayerAction{cmd.command, d, 0, 0});
                 break; }
-            case Command::Wait:
-                state.requestTick();
-                break;
             case Command::ShowMap:
                 doShowMap(state);
                 break;
@@ -386,40 +648,6 @@ void gfx_handleInput(GameState &state) {
                 break;
 
 
-            case Command::NextSubweapon: {
-                bool hasSubweapon = false;
-                for (int i = 0; i < SW_COUNT; ++i) {
-                    if (state.subweaponLevel[i] > 0) {
-                        hasSubweapon = true;
-                        break;
-                    }
-                }
-                if (!hasSubweapon) {
-                    state.currentSubweapon = -1;
-                } else {
-                    do {
-                        ++state.currentSubweapon;
-                        if (state.currentSubweapon >= SW_COUNT) state.currentSubweapon = 0;
-                    } while (state.subweaponLevel[state.currentSubweapon] == 0);
-                }
-                break; }
-            case Command::PrevSubweapon: {
-                bool hasSubweapon = false;
-                for (int i = 0; i < SW_COUNT; ++i) {
-                    if (state.subweaponLevel[i] > 0) {
-                        hasSubweapon = true;
-                        break;
-                    }
-                }
-                if (!hasSubweapon) {
-                    state.currentSubweapon = -1;
-                } else {
-                    do {
-                        --state.currentSubweapon;
-                        if (state.currentSubweapon < 0) state.currentSubweapon = SW_COUNT - 1;
-                    } while (state.subweaponLevel[state.currentSubweapon] == 0);
-                }
-                break; }
             case Command::Subweapon: {
                 if (state.currentSubweapon == -1) {
                     state.addMessage("You don't have any subweapons.");
@@ -430,77 +658,24 @@ void gfx_handleInput(GameState &state) {
                     d = gfx_GetDirection(state, state.subweapons[state.currentSubweapon].name);
                     if (d == Dir::None) break;
                 }
-                switch(state.currentSubweapon) {
-                    case SW_BOW:
-                        if (state.arrowCount <= 0) {
-                            state.addMessage("Out of ammo!");
-                            break;
-                        }
-                        --state.arrowCount;
-                        state.requestTick();
-                        basicProjectileAttack(state, projectiles[projArrow], d);
-                        break;
-                    case SW_FIREROD:
-                        if (state.getPlayer()->curEnergy < 3) {
-                            state.addMessage("Out of energy!");
-                            break;
-                        }
-                        state.getPlayer()->curEnergy -= 3;
-                        state.requestTick();
-                        basicProjectileAttack(state, projectiles[projFireBolt], d);
-                        break;
-                    case SW_ICEROD:
-                        if (state.getPlayer()->curEnergy < 3) {
-                            state.addMessage("Out of energy!");
-                            break;
-                        }
-                        state.getPlayer()->curEnergy -= 3;
-                        state.requestTick();
-                        basicProjectileAttack(state, projectiles[projIceBolt], d);
-                        break;
-                    case SW_PICKAXE: {
-                        Actor *actor = state.getBoard()->actorAt(state.getPlayer()->position.shift(d));
-                        if (actor) {
-                            state.requestTick();
-                            bool isHit = doAccuracyCheck(state, state.getPlayer(), actor, -2);
-                            if (!isHit) {
-                                state.addMessage("You miss " + actor->getName() + ".");
-                            } else {
-                                int roll = state.coreRNG.roll(3, 4);
-                                if (state.config->getBool("showrolls", false)) {
-                                    std::stringstream msg2;
-                                    msg2 << "[damage: 3d4" << '=' << roll << ']';
-                                    state.addInfo(msg2.str());
-                                }
-                                state.getBoard()->doDamage(state, actor, roll, 0, "your pickaxe");
-                            }
-                        } else {
-                            state.addMessage("Your pickaxe has no impact.");
-                        }
-                        break; }
-                    case SW_BOMB: {
-                        if (state.bombCount <= 0) {
-                            state.addMessage("You don't have any bombs.");
-                            break;
-                        }
-                        Point dest = state.getPlayer()->position.shift(d);
-                        const TileInfo &tileInfo = TileInfo::get(state.getBoard()->getTile(dest));
-                        Actor *existing = state.getBoard()->actorAt(dest);
-                        if (tileInfo.flags & TF_SOLID || existing) {
-                            state.addMessage("There's no space.");
-                        } else {
-                            --state.bombCount;
-                            if (state.bombCount <= 0) state.subweaponLevel[SW_BOMB] = 0;
-                            Actor *bomb = new Actor(1);
-                            bomb->reset();
-                            bomb->ai_pathNext = 5;
-                            state.getBoard()->addActor(bomb, dest);
-                        }
-                        break; }
-                    default:
-                        state.addError("The " + state.subweapons[state.currentSubweapon].name + " is not implemented.");
-                }
+                takeAction(state, PlayerAction{cmd.command, d, 0, 0});
                 break; }
+            case Command::QuickSave:
+                if (saveGame(state, quicksaveFile)) state.addInfo("Game saved.");
+                else                                state.addError("Failed to save the game.");
+                break;
+            case Command::QuickLoad:
+                if (!saveExists(quicksaveFile)) {
+                    state.addMessage("There is no quicksave to load.");
+                } else if (loadGame(state, quicksaveFile)) {
+                    state.addInfo("Game loaded.");
+                } else if (!state.gameInProgress) {
+                    state.returnToMenu = true;
+                    return;
+                } else {
+                    state.addError("Failed to load the quicksave.");
+                }
+                break;
 
             case Command::Debug_MapEditMode:
                 state.getBoard()->dbgRevealAll();
@@ -515,10 +690,7 @@ void gfx_handleInput(GameState &state) {
                 std::string mapIdStr;
                 if (gfx_EditText(state, "Map Number", mapIdStr, 10)) {
                     int mapId = strToInt(mapIdStr);
-                    if (mapId >= 0) {
-                        Point position = state.getPlayer()->position;
-                        state.warpTo(mapId, position.x(), position.y());
-                    }
+                    if (mapId >= 0) takeAction(state, PlayerAction{cmd.command, Dir::None, mapId, 0});
                 }
                 break; }
             case Command::Debug_Teleport: {
@@ -532,14 +704,8 @@ void gfx_handleInput(GameState &state) {
                 if (y < 0) y = 0;
                 if (x > state.getBoard()->width())  x = state.getBoard()->width() - 1;
                 if (y > state.getBoard()->height()) y = state.getBoard()->height() - 1;
-                state.warpTo(-1, x, y);
+                takeAction(state, PlayerAction{cmd.command, Dir::None, x, y});
                 break; }
-            case Command::Debug_Restore:
-                state.getPlayer()->curHealth = state.getPlayer()->typeInfo->maxHealth;
-                state.getPlayer()->curEnergy = state.getPlayer()->typeInfo->maxEnergy;
-                state.bombCount = state.bombCapacity;
-                state.arrowCount = state.arrowCapacity;
-                break;
             case Command::Debug_Reveal:
                 state.getBoard()->dbgRevealAll();
                 break;
@@ -552,11 +718,26 @@ void gfx_handleInput(GameState &state) {
             case Command::Debug_ShowFPS:
                 state.showFPS = !state.showFPS;
                 break;
+            case Command::Debug_Rewind:
+            case Command::Debug_Redo: {
+                // not recorded; a replay of a game that was rewound won't match
+                if (!state.journal.enabled()) {
+                    state.addError("The journal is off; set journal_turns to rewind.");
+                    break;
+                }
+                const bool rewinding = cmd.command == Command::Debug_Rewind;
+                std::string countStr = "1";
+                if (!gfx_EditText(state, rewinding ? "Rewind Turns" : "Redo Turns", countStr, 6)) break;
+                const int count = strToInt(countStr);
+                if (count <= 0) break;
+                const int done = rewinding ? state.journal.rewind(state, count) : state.journal.redo(state, count);
+                state.addError((rewinding ? "Rewound " : "Redid ") + std::to_string(done) + " turns.");
+                break; }
             case Command::Debug_TestPathfinder: {
                 Board *board = state.getBoard();
                 board->resetMark();
                 Point src = state.getPlayer()->position;
-                Point dest = board->findRandomTile(state.coreRNG, tileFloor);
+                Point dest = board->findRandomTile(state.miscRNG, tileFloor);
                 std::stringstream line;
                 line << "Finding path from " << src << " to " << dest << '.';
                 state.addError(line.str());
@@ -3,28 +3,13 @@
 #include "actor.h"
 #include "logger.h"
 #include "board.h"
+#include "config.h"
 #include "vm.h"
 #include "gamestate.h"
+#include "gfx_minimap.h"
+#include "workerpool.h"
 
 
-AnimFrame::AnimFrame(int type)
-: special(type)
-{ }
-
-AnimFrame::AnimFrame(const Point &point, SDL_Texture *texture)
-: special(animFrame)
-{
-    data.insert(std::make_pair(point, texture));
-}
-
-AnimFrame::AnimFrame(int type, const std::string &text)
-: special(type), text(text)
-{ }
-
-AnimFrame::AnimFrame(Actor *actor, int amount, int damageType, const std::string &source)
-: special(animDamage), actor(actor), damageAmount(amount), damageType(damageType), text(source)
-{ }
-
 GameState::GameState(SDL_Renderer *renderer, Random &rng)
 : runDirection(Dir::None),
   swordLevel(0), armourLevel(0),
@@ -33,11 +18,15 @@ GameState::GameState(SDL_Renderer *renderer, Random &rng)
   arrowCapacity(30), bombCapacity(10), currentSubweapon(-1),
   turnNumber(1), depth(0), mCurrentBoard(nullptr),  mPlayer(nullptr),
   cursor(-1,-1), smallFont(nullptr), tinyFont(nullptr), mCurrentTrack(-1),
-  mCurrentMusic(nullptr),renderer(renderer), coreRNG(rng), vm(nullptr),
-  config(nullptr), wantsToQuit(false), gameInProgress(false), returnToMenu(false), showTooltip(false),
-  showInfo(false), showFPS(false), wantsTick(false),
-  mapEditTile(-1), framecount(0), framerate(0), baseticks(0), lastticks(0), fps(0)
+  mCurrentMusic(nullptr), mLoader(nullptr), mAssetStats{0, 0, 0, 0, 0}, renderer(renderer), tileLayer(nullptr), atlas(nullptr), minimap(nullptr), workers(nullptr), coreRNG(rng), gameSeed(0), vm(nullptr),
+  config(nullptr), recording(nullptr), wantsToQuit(false), gameInProgress(false), returnToMenu(false), showTooltip(false),
+  showInfo(false), showFPS(false), wantsTick(false), idleRendering(true),
+  replaying(false),
+  mapEditTile(-1), framecount(0), framerate(0), baseticks(0), fps(0),
+  mWaitedForEvent(false), mFrameRequested(false), mFrameDeadline(0),
+  mFrameStart(0), mIdleTime(0), mFpsStart(0), mFpsFrames(0)
 {
+    resetFrameTimer();
 }
 
 GameState::~GameState() {
@@ -45,15 +34,22 @@ GameState::~GameState() {
 }
 
 void GameState::reset() {
+    reset(coreRNG.next64());
+}
+
+void GameState::reset(std::uint64_t seed) {
     Logger &logger = Logger::getInstance();
     logger.info("Resetting game state");
     endGame();
+    seedStreams(seed);
 
     unsigned count = 0;
     for (const MapInfo &mapInfo : MapInfo::types) {
         Board *newBoard = new Board(mapInfo);
+        newBoard->setSymmetricFOV(config->settings().symmetricFOV);
         mCurrentBoard = newBoard;
         if (mapInfo.onBuild) vm->run(mapInfo.onBuild);
+        newBoard->markBuilt();
         mBoards.insert(std::make_pair(mapInfo.index, newBoard));
         ++count;
     }
@@ -64,21 +60,51 @@ void GameState::reset() {
     mCurrentBoard = nullptr;
     wantsTick = false;
 
-    mPlayer = new Actor(playerTypeId);
-    mPlayer->name = "player";
+    playerDetails.clear();
+    playerDetails.name = "player";
+    mPlayer = new Actor(playerTypeId, &playerDetails);
     mPlayer->isPlayer = true;
-    mPlayer->talkFunc = 0;
+    mPlayer->id = playerActorId;
     mPlayer->reset();
 }
 
 void GameState::endGame() {
     messages.clear();
+    animations.clear();
+    if (minimap) minimap->clear();
+    journal.clear();
     if (mCurrentBoard) mCurrentBoard = nullptr;
-    if (mPlayer) mPlayer = nullptr;
     for (auto boardIter : mBoards) {
         delete boardIter.second;
     }
     mBoards.clear();
+    // boards only own the actors in their pools, never the player
+    delete mPlayer;
+    mPlayer = nullptr;
+}
+
+// Everything random in a game comes from these streams, so the same seed
+// always plays out the same way given the same input.
+void GameState::seedStreams(std::uint64_t seed) {
+    gameSeed = seed;
+    Random base;
+    base.seed(seed);
+    mapRNG = base.split(rngStreamMap);
+    aiRNG = base.split(rngStreamAI);
+    lootRNG = base.split(rngStreamLoot);
+    combatRNG = base.split(rngStreamCombat);
+    miscRNG = base.split(rngStreamMisc);
+}
+
+// Bring everything that depends on the configuration up to date.
+void GameState::applySettings(const Settings &settings) {
+    setFontScale(settings.fontScale);
+    idleRendering = settings.idleRender;
+    messages.setCapacity(settings.messageHistory);
+    journal.setCapacity(settings.journalTurns);
+    for (auto iter : mBoards) {
+        iter.second->setSymmetricFOV(settings.symmetricFOV);
+    }
 }
 
 void GameState::setFontScale(int scale) {
@@ -87,40 +113,38 @@ void GameState::setFontScale(int scale) {
     }
 }
 
-void GameState::queueFrame(const AnimFrame &frame) {
-    animationQueue.push_back(frame);
+// The time in ms each step of an animation is shown for.
+unsigned GameState::animationDelay() const {
+    return config->settings().animDelay;
 }
 
-void GameState::queueFrames(const std::vector<AnimFrame> &frame) {
-    animationQueue.insert(animationQueue.begin(), frame.begin(), frame.end());
+// The worker threads are started the first time something needs them. The
+// calling thread also takes jobs, so one less than the CPU count are started.
+WorkerPool* GameState::getWorkers() {
+    if (!workers) {
+        workers = new WorkerPool(SDL_GetCPUCount() - 1);
+        Logger::getInstance().info("Started " + std::to_string(workers->threadCount()) + " worker threads.");
+    }
+    return workers;
 }
 
 void GameState::addMessage(const std::string &text) {
-    messages.push_back(Message{
-        turnNumber,
-        text
-    });
+    messages.add(turnNumber, text);
 }
 
 void GameState::addInfo(const std::string &text) {
-    messages.push_back(Message{
-        turnNumber,
-        "\x1B\x02\x7F\x7F\xFF" + text
-    });
+    messages.add(turnNumber, "\x1B\x02\x7F\x7F\xFF" + text);
 }
 
 void GameState::addError(const std::string &text) {
-    messages.push_back(Message{
-        turnNumber,
-        "\x1B\x02\xFF\x7F\x7F" + text
-    });
+    messages.add(turnNumber, "\x1B\x02\xFF\x7F\x7F" + text);
 }
 
 void GameState::appendMessage(const std::string &newText) {
     if (messages.empty()) {
         addMessage(newText);
     } else {
-        messages.back().text += newText;
+        messages.appendToLast(newText);
     }
 }
 
@@ -128,14 +152,12 @@ void GameState::replaceMessage(const std::string &newText) {
     if (messages.empty()) {
         addMessage(newText);
     } else {
-        messages.back().text = newText;
+        messages.replaceLast(newText);
     }
 }
 
 void GameState::removeMessage() {
-    if (!messages.empty()) {
-        messages.pop_back();
-    }
+    messages.removeLast();
 }
 
 void GameState::requestTick() {
@@ -151,6 +173,7 @@ void GameState::tick() {
     if (mCurrentBoard) {
         mCurrentBoard->tick(*this);
         ++turnNumber;
+        journal.endTurn(*this);
     }
 }
 
@@ -229,6 +252,7 @@ bool GameState::switchBoard(int forIndex) {
 
     if (mCurrentBoard) {
         mCurrentBoard->removeActor(mPlayer);
+        mCurrentBoard->setLeftOnTurn(turnNumber);
     }
 
     auto oldBoard = mBoards.find(forIndex);
@@ -238,7 +262,14 @@ bool GameState::switchBoard(int forIndex) {
         return false;
     }
     mCurrentBoard = oldBoard->second;
-    mCurrentBoard->reset(*this);
+    const Settings &settings = config->settings();
+    if (settings.persistentBoards && mCurrentBoard->getLeftOnTurn() >= 0) {
+        int elapsed = turnNumber - mCurrentBoard->getLeftOnTurn();
+        if (elapsed > settings.catchUpTurns) elapsed = settings.catchUpTurns;
+        mCurrentBoard->catchUp(elapsed, aiRNG);
+    } else {
+        mCurrentBoard->reset(*this);
+    }
     depth = forIndex;
     if (info.musicTrack >= 0) {
 
@@ -372,16 +403,76 @@ bool GameState::hasItem(int itemId) {
     return false;
 }
 
+// Wait out the rest of the current frame and record how long it took, not
+// counting any time spent idle in nextEvent. SDL_Delay can oversleep by a
+// millisecond or more, so the last frameSpinTime ms are spun instead.
 void GameState::advanceFrame() {
     ++framecount;
-    ++timerFrames;
-    unsigned newTime = SDL_GetTicks();
-    unsigned frameTime = newTime - lastticks;
-    const unsigned MS_PER_FRAME = 16;
-    if (frameTime < MS_PER_FRAME) SDL_Delay(MS_PER_FRAME - frameTime);
-    lastticks = SDL_GetTicks();
+    const Uint64 frequency = SDL_GetPerformanceFrequency();
+    const Uint64 frameLength = frequency / targetFrameRate;
+    const Uint64 target = mFrameStart + mIdleTime + frameLength;
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (now < target) {
+        Uint64 remaining = (target - now) * 1000 / frequency;
+        if (remaining > frameSpinTime) SDL_Delay(remaining - frameSpinTime);
+        while ((now = SDL_GetPerformanceCounter()) < target) { }
+    }
+    frameStats.add(static_cast<double>(now - mFrameStart - mIdleTime) * 1000.0 / frequency);
+
+    ++mFpsFrames;
+    if (now - mFpsStart >= frequency) {
+        fps = mFpsFrames * frequency / (now - mFpsStart);
+        mFpsFrames = 0;
+        mFpsStart = now;
+    }
+
+    mFrameStart = now;
+    mIdleTime = 0;
+    mWaitedForEvent = false;
+}
+
+// Start timing frames afresh, so that time spent outside of the usual frame
+// loops (e.g. loading a game) isn't counted as a slow frame.
+void GameState::resetFrameTimer() {
+    mFrameStart = mFpsStart = SDL_GetPerformanceCounter();
+    mIdleTime = 0;
+    mFpsFrames = 0;
 }
 
 unsigned GameState::getFPS() const {
     return fps;
 }
+
+unsigned GameState::animationStep() const {
+    return SDL_GetTicks() / animStepTime;
+}
+
+// Ask for the next frame to be drawn no later than ticks (as returned by
+// SDL_GetTicks). Only the earliest request since the last frame matters.
+void GameState::requestFrameAt(unsigned ticks) {
+    if (!mFrameRequested || ticks < mFrameDeadline) mFrameDeadline = ticks;
+    mFrameRequested = true;
+}
+
+// Replacement for SDL_PollEvent in loops that redraw after handling events.
+// The first call after a frame sleeps until an event arrives or a requested
+// frame is due; further calls just poll. Returns false once there are no more
+// events to handle before drawing.
+bool GameState::nextEvent(SDL_Event &event) {
+    if (mWaitedForEvent || !idleRendering) return SDL_PollEvent(&event);
+    mWaitedForEvent = true;
+
+    unsigned timeout = idleMaxWait;
+    if (mFrameRequested) {
+        unsigned now = SDL_GetTicks();
+        timeout = mFrameDeadline > now ? mFrameDeadline - now : 0;
+        if (timeout > idleMaxWait) timeout = idleMaxWait;
+    }
+    if (isLoading() && timeout > loadingPollTime) timeout = loadingPollTime;
+    mFrameRequested = false;
+    if (timeout == 0) return SDL_PollEvent(&event);
+    const Uint64 waitStart = SDL_GetPerformanceCounter();
+    bool gotEvent = SDL_WaitEventTimeout(&event, timeout);
+    mIdleTime += SDL_GetPerformanceCounter() - waitStart;
+    return gotEvent;
+}
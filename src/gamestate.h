@@ -3,22 +3,33 @@
 
 #include <SDL2/SDL_mixer.h>
 
-#include <deque>
 #include <map>
 #include <string>
 #include <vector>
+#include "actor.h"
+#include "animation.h"
+#include "framestats.h"
+#include "journal.h"
+#include "messagelog.h"
 #include "point.h"
+#include "random.h"
 
 class Board;
-class Actor;
-class Random;
 struct SDL_Renderer;
 struct SDL_Window;
 struct SDL_Texture;
 class Font;
 class VM;
 class Config;
+struct Settings;
+class AssetLoader;
+class TileLayer;
+class SpriteAtlas;
+class Minimap;
+class WorkerPool;
+class Recording;
 struct SDL_Rect;
+union SDL_Event;
 
 const int SW_BOW = 0;
 const int SW_HOOKSHOT = 1;
@@ -28,6 +39,14 @@ const int SW_FIREROD = 4;
 const int SW_ICEROD = 5;
 const int SW_COUNT = 6;
 
+// streams split off the core generator for each subsystem, so that (say) an
+// extra combat roll doesn't change the maps that get generated
+const int rngStreamMap      = 1;
+const int rngStreamAI       = 2;
+const int rngStreamLoot     = 3;
+const int rngStreamCombat   = 4;
+const int rngStreamMisc     = 5;
+
 const int ITM_SWORD_UPGRADE  = 0;
 const int ITM_ARMOUR_UPGRADE = 1;
 const int ITM_HEALTH_UPGRADE = 2;
@@ -53,22 +72,16 @@ const int animFrame = 0;
 const int animDamage = 1;
 const int animText = 2;
 const int animRollText = 3;
-struct AnimFrame {
-    AnimFrame(int type);
-    AnimFrame(const Point &point, SDL_Texture *texture);
-    AnimFrame(int type, const std::string &text);
-    AnimFrame(Actor *actor, int amount, int damageType, const std::string &source);
-
-    int special;
-    // for animation frames
-    std::map<Point, SDL_Texture*> data;
-    // for damage frames
-    Actor *actor;
-    int damageAmount, damageType;
-    // for damage, message, and roll frames
-    std::string text;
-};
 
+// tile animations advance once every animStepTime ms; while nothing needs
+// drawing, the event loops sleep for up to idleMaxWait ms (or loadingPollTime
+// ms while assets are loading)
+const unsigned animStepTime = 200;
+const unsigned idleMaxWait = 1000;
+const unsigned loadingPollTime = 50;
+
+const unsigned targetFrameRate = 60;
+const unsigned frameSpinTime = 2;
 struct TrackInfo {
     int number;
     std::string file;
@@ -76,11 +89,6 @@ struct TrackInfo {
     std::string artist;
 };
 
-struct Message {
-    int newTurns;
-    std::string text;
-};
-
 struct ItemLocation {
     int itemId;
     bool used;
@@ -119,6 +127,22 @@ struct Item {
     int fromLocation;
 };
 
+typedef int ImageHandle;
+const ImageHandle noImage = -1;
+
+struct ImageAsset {
+    std::string name;
+    SDL_Texture *texture;
+    int refCount;
+    unsigned bytes;
+    bool failed;
+};
+
+struct AssetStats {
+    unsigned hits, misses, failures, evictions;
+    unsigned long residentBytes;
+};
+
 struct World {
     std::string name;
     int index;
@@ -142,21 +166,36 @@ public:
     GameState(SDL_Renderer *renderer, Random &rng);
     ~GameState();
 
-    bool load();
+    bool beginLoad();
+    void pollLoading();
+    void finishLoading();
+    bool isLoading() const;
+    void getLoadProgress(int &done, int &total) const;
     void unloadAll();
     void reset();
+    void reset(std::uint64_t seed);
     void endGame();
+    void seedStreams(std::uint64_t seed);
 
     SDL_Texture* getImageCore(const std::string &name);
     SDL_Texture* getImage(const std::string &name);
+    SDL_Texture* holdDataImage(const std::string &name);
+    ImageHandle acquireImage(const std::string &name);
+    void releaseImage(ImageHandle handle);
+    SDL_Texture* imageFromHandle(ImageHandle handle) const;
+    bool preloadImages(const std::string &manifestFile);
+    void buildAtlas();
+    const AssetStats& getAssetStats() const;
+    void logAssetStats() const;
     Mix_Music* getMusic(const std::string &name);
     Mix_Chunk* getAudio(const std::string &name);
     Font* getFont(const std::string &name);
 
     void setFontScale(int scale);
+    void applySettings(const Settings &settings);
 
-    void queueFrame(const AnimFrame &frame);
-    void queueFrames(const std::vector<AnimFrame> &frame);
+    unsigned animationDelay() const;
+    WorkerPool* getWorkers();
 
     void playMusic(int trackNumber);
     void setMusicVolume(int volume);
@@ -194,7 +233,11 @@ public:
     bool hasItem(int itemId);
 
     void advanceFrame();
+    void resetFrameTimer();
     unsigned getFPS() const;
+    unsigned animationStep() const;
+    void requestFrameAt(unsigned ticks);
+    bool nextEvent(SDL_Event &event);
 
     // player state
     Dir runDirection;
@@ -205,13 +248,15 @@ public:
     int currentSubweapon;
 
     // message log
-    std::vector<Message> messages;
+    MessageLog messages;
+    Journal journal;
 
     // Map data
     int turnNumber;
     int depth;
     Board *mCurrentBoard;
     Actor *mPlayer;
+    ActorDetails playerDetails;
     std::map<int, Board*> mBoards;
     Point cursor;
 
@@ -223,21 +268,36 @@ public:
     std::map<int, SDL_Texture*> mTiles;
     std::map<int, TrackInfo> mTracks;
     std::map<int, Mix_Chunk*> mAudio;
-    std::map<std::string, SDL_Texture*> mImages;
+    AssetLoader *mLoader;
+    std::map<std::string, ImageHandle> mImages;
+    std::vector<ImageAsset> mImageAssets;
+    std::vector<ImageHandle> mDataImages;
+    AssetStats mAssetStats;
     std::map<std::string, Font*> mFonts;
     std::vector<ItemLocation> itemLocations;
     std::vector<Subweapon> subweapons;
     std::vector<LootTable> lootTables;
     std::vector<ItemDef> itemDefs;
     std::vector<World> worlds;
-    std::deque<AnimFrame> animationQueue;
+    Timeline animations;
 
     // system modules
     SDL_Renderer *renderer;
     SDL_Window *window;
+    TileLayer *tileLayer;
+    SpriteAtlas *atlas;
+    Minimap *minimap;
+    WorkerPool *workers;
     Random &coreRNG;
+    std::uint64_t gameSeed;
+    Random mapRNG, aiRNG, lootRNG, combatRNG;
+    // for things that don't change how the game plays out, such as the
+    // player's default name and debug commands, so that drawing from it
+    // doesn't throw replays off
+    Random miscRNG;
     VM *vm;
     Config *config;
+    Recording *recording;
 
     // game configuration flags
     bool wantsToQuit;
@@ -247,8 +307,12 @@ public:
     bool showInfo;
     bool showFPS;
     bool wantsTick;
+    bool idleRendering;
+    bool replaying;
     int  mapEditTile;
 
+    void queueAssets();
+    bool finishLoad();
     bool loadAudioTracks();
     bool loadActorData();
     bool loadItemDefs();
@@ -260,8 +324,13 @@ public:
     bool loadLootTables();
     bool loadWorldData();
 
-    int framecount, framerate, baseticks, lastticks, fps;
-    int timerFrames, timerTime, actualFPS;
+    int framecount, framerate, baseticks, fps;
+    int timerTime, actualFPS;
+    bool mWaitedForEvent, mFrameRequested;
+    unsigned mFrameDeadline;
+    FrameStats frameStats;
+    Uint64 mFrameStart, mIdleTime, mFpsStart;
+    unsigned mFpsFrames;
     double tickrate;
 
     std::string gameName;
@@ -278,10 +347,25 @@ public:
     int getCharHeight() const;
     int getLineHeight() const;
     void out(int x, int y, const std::string &text, const Color &defaultColor = Color{255,255,255});
+    void clearCache();
 private:
+    // a character cell and colour, positioned in character columns and lines so
+    // that the layout doesn't depend on the current scale
+    struct Glyph {
+        int column, line;
+        unsigned char c;
+        Color color;
+    };
+    typedef std::vector<Glyph> TextLayout;
+
+    const TextLayout& layout(const std::string &text, const Color &defaultColor);
+
     SDL_Renderer *mRenderer;
     SDL_Texture *mTexture;
     int mScale, mCharWidth, mCharHeight, mLineSpace;
+    int mTextureWidth, mTextureHeight;
+    std::map<std::string, TextLayout> mLayouts;
+    std::string mKey;
 };
 
 const int charStats = 0;
@@ -290,8 +374,9 @@ const int charInventory = 2;
 const int charModeCount = 3;
 
 char* slurpFile(const std::string &filename);
+std::vector<std::string> readManifest(const std::string &filename);
 
-bool repaint(GameState &state, const AnimFrame *frame = nullptr, bool callPresent = true);
+void repaint(GameState &state, bool callPresent = true);
 
 void doCharInfo(GameState &system);
 void doCredits(GameState &state);
@@ -302,6 +387,11 @@ bool gfx_Confirm(GameState &state, const std::string &line1, const std::string &
 void gfx_Alert(GameState &state, const std::string &line1, const std::string &line2);
 bool gfx_EditText(GameState &system, const std::string &prompt, std::string &text, int maxLength);
 void gfx_DrawTooltip(GameState &system, int x, int y, const std::string &text);
+void gfx_DrawFrameStats(GameState &system, int x, int y);
+void gfx_drawMap(GameState &state);
+void gfx_drawSidebar(GameState &state);
+void gfx_doDrawToolTip(GameState &state);
+void gfx_drawToolTipAt(GameState &state, int mouseX, int mouseY);
 
 bool pointInBox(int x, int y, const SDL_Rect &box);
 int gfx_DrawFrame(GameState &system, int x, int y, int w, int h, const std::string &title);
@@ -1,9 +1,9 @@
 #include <cstdlib>
-#include <deque>
 #include <vector>
 
 #include "board.h"
 #include "point.h"
+#include "random.h"
 
 Dir openDirection(Board *board, const Point &point);
 void addNewDoor(Board *board, const Point &here, Random &rng);
@@ -71,12 +71,30 @@ struct Room {
     bool forceHollow;
 };
 
+// Pick a random point from a list and remove it by swapping the last point
+// into its place.
+static Point takeRandomPoint(std::vector<Point> &points, Random &rng) {
+    const unsigned index = rng.below(points.size());
+    Point result = points[index];
+    points[index] = points.back();
+    points.pop_back();
+    return result;
+}
+
+// The generator was tuned for 95x95 maps; larger maps get proportionally
+// more rooms and decorations so they look the same.
+static int scaleForArea(const Board *board, int count) {
+    const long long area = static_cast<long long>(board->width()) * board->height();
+    const long long scaled = count * area / (95 * 95);
+    return scaled > count ? static_cast<int>(scaled) : count;
+}
+
 void makeMapMaze(Board *board, Random &rng, unsigned flags) {
     if (!board) return;
-    Point start(1 + 2 * (rand() % (board->width() / 2 - 2)),
-                1 + 2 * (rand() % (board->height() / 2 - 2)));
+    Point start(1 + 2 * rng.below(board->width() / 2 - 2),
+                1 + 2 * rng.below(board->height() / 2 - 2));
     std::vector<Room> rooms;
-    std::deque<Point> list;
+    std::vector<Point> list;
     list.push_back(start);
     board->clearTo(tileWall);
     board->setTile(start, tileFloor);
@@ -91,11 +109,12 @@ void makeMapMaze(Board *board, Random &rng, unsigned flags) {
     setTiles(board, centralRoomtopLeft, centralWidth, centralHeight, tileInterior);
 
     // add some room templates
-    for (int i = 0; i < 60; ++i) {
-        Point topleft(1 + 2 * (rand() % (board->width() / 2 - 2)),
-                      1 + 2 * (rand() % (board->height() / 2 - 2)));
-        int width = 1 + rand() % 6;
-        int height = 1 + rand() % 6;
+    const int roomAttempts = scaleForArea(board, 60);
+    for (int i = 0; i < roomAttempts; ++i) {
+        Point topleft(1 + 2 * rng.below(board->width() / 2 - 2),
+                      1 + 2 * rng.below(board->height() / 2 - 2));
+        int width = 1 + rng.below(6);
+        int height = 1 + rng.below(6);
         if (width % 2 == 0) ++width;
         if (height % 2 == 0) ++height;
         if (topleft.x() + width  > board->width()  - 1 ||
@@ -108,30 +127,24 @@ void makeMapMaze(Board *board, Random &rng, unsigned flags) {
         }
 
         rooms.push_back(Room(topleft.x(), topleft.y(), width, height));
-
-        for (int y = 0; y < height; ++y) {
-            for (int x = 0; x < width; ++x) {
-                board->setTile(Point(topleft.x() + x, topleft.y() + y), tileInterior);
-            }
-        }
+        setTiles(board, topleft, width, height, tileInterior);
     }
 
-    // build the maze
+    // build the maze; a point stays on the list until it has no walls left
+    // to dig into
     while (!list.empty()) {
-        int index = rand() % list.size();
-        Point here = list[index];
+        const unsigned index = rng.below(list.size());
+        const Point here = list[index];
 
-        Point dest;
         Dir initialDir = randomDirection(rng);
         Dir dir = initialDir;
         bool success = false;
         do {
-            dest = Point(here);
-            dest = dest.shift(dir, 2);
+            const Point dest = here.shift(dir, 2);
             if (board->getTile(dest) == tileWall) {
-                list.push_front(dest);
                 board->setTile(dest, tileFloor);
                 board->setTile(here.shift(dir, 1), tileFloor);
+                list.push_back(dest);
                 success = true;
                 break;
             }
@@ -140,58 +153,51 @@ void makeMapMaze(Board *board, Random &rng, unsigned flags) {
         } while (dir != initialDir);
 
         if (!success) {
-            list.erase(list.begin()+index);
+            list[index] = list.back();
+            list.pop_back();
         }
     }
 
     // build the room interiors
+    std::vector<Point> doorSpots;
     for (const Room &room : rooms) {
         bool makeSolid = true;
-        if (room.w >= 3 && room.h >= 3 && rand() % 6 != 2) makeSolid = false;
+        if (room.w >= 3 && room.h >= 3 && rng.below(6) != 2) makeSolid = false;
         if (room.forceHollow) makeSolid = false;
 
         setTiles(board, Point(room.x, room.y), room.w, room.h, makeSolid ? tileWall : tileFloor);
         if (makeSolid) continue;
 
-        const int maxIterations = 100;
-        int iterations = 0;
-        Point doorLoc;
-        bool vert = rand() % 2 == 0;
-        bool side = rand() % 2 == 0;
-        do {
-            if (vert) {
-                doorLoc = Point(side ?
-                                    room.x - 1 :
-                                    room.x + room.w,
-                                room.y + rand() % room.h);
-            } else {
-                doorLoc = Point(room.x + rand() % room.w,
-                                side ?
-                                    room.y - 1 :
-                                    room.y + room.h);
+        // the door goes somewhere valid along one randomly chosen side
+        bool vert = rng.below(2) == 0;
+        bool side = rng.below(2) == 0;
+        doorSpots.clear();
+        if (vert) {
+            const int x = side ? room.x - 1 : room.x + room.w;
+            for (int y = room.y; y < room.y + room.h; ++y) {
+                if (validDoorLocation(board, Point(x, y))) doorSpots.push_back(Point(x, y));
             }
-            ++iterations;
-        } while (!validDoorLocation(board, doorLoc) && iterations <= maxIterations);
-
-        if (validDoorLocation(board, doorLoc)) {
-            board->setTile(doorLoc, tileDoorClosed);
         } else {
-            if (!room.forceHollow)
-                makeSolid = true;
+            const int y = side ? room.y - 1 : room.y + room.h;
+            for (int x = room.x; x < room.x + room.w; ++x) {
+                if (validDoorLocation(board, Point(x, y))) doorSpots.push_back(Point(x, y));
+            }
         }
 
-        if (makeSolid) {
+        if (!doorSpots.empty()) {
+            board->setTile(takeRandomPoint(doorSpots, rng), tileDoorClosed);
+        } else if (!room.forceHollow) {
             setTiles(board, Point(room.x, room.y), room.w, room.h, tileWall);
         }
-
     }
 
     trimDeadEnds(board, 100, rng);
 
     // add some random doors, windows, and secrets to the map
-    for (int i = 0; i < 100; ++i) {
-        Point here = Point(1 + (rand() % (board->width() - 2)),
-                           1 + (rand() % (board->height() - 2)));
+    const int decorAttempts = scaleForArea(board, 100);
+    for (int i = 0; i < decorAttempts; ++i) {
+        Point here = Point(1 + rng.below(board->width() - 2),
+                           1 + rng.below(board->height() - 2));
 
         if (!validDoorLocation(board, here)) {
             continue;
@@ -203,34 +209,31 @@ void makeMapMaze(Board *board, Random &rng, unsigned flags) {
         int decor[4] = { tileDoorClosed, tileDoorClosed, tileWindow };
         switch(tile) {
             case tileWall:
-                roll = rand() % 3;
+                roll = rng.below(3);
                 board->setTile(here, decor[roll]);
                 break;
             case tileFloor:
-                roll = rand() % 2;
+                roll = rng.below(2);
                 board->setTile(here, decor[roll]);
                 break;
         }
     }
 
-    // add the down stairs
-    if (flags & MF_ADD_DOWN) {
-        Point downStair;
-        do {
-            downStair = Point(1 + (rand() % (board->width() - 2)),
-                            1 + (rand() % (board->height() - 2)));
-        } while (board->getTile(downStair) != tileFloor);
-        board->setTile(downStair, tileDown);
-    }
-
-    // add the up stairs
-    if (flags & MF_ADD_UP) {
-        Point upStair;
-        do {
-            upStair = Point(1 + (rand() % (board->width() - 2)),
-                            1 + (rand() % (board->height() - 2)));
-        } while (board->getTile(upStair) != tileFloor);
-        board->setTile(upStair, tileUp);
+    // add the stairs, chosen from every floor tile so that placing them
+    // always finishes
+    if (flags & (MF_ADD_DOWN | MF_ADD_UP)) {
+        std::vector<Point> floors;
+        for (int y = 1; y < board->height() - 1; ++y) {
+            for (int x = 1; x < board->width() - 1; ++x) {
+                if (board->getTile(Point(x, y)) == tileFloor) floors.push_back(Point(x, y));
+            }
+        }
+        if ((flags & MF_ADD_DOWN) && !floors.empty()) {
+            board->setTile(takeRandomPoint(floors, rng), tileDown);
+        }
+        if ((flags & MF_ADD_UP) && !floors.empty()) {
+            board->setTile(takeRandomPoint(floors, rng), tileUp);
+        }
     }
 }
 
@@ -261,7 +264,7 @@ void addNewDoor(Board *board, const Point &here, Random &rng) {
         Point dest = here.shift(theDir, 1);
         int tile = board->getTile(dest);
         if (tile == tileWall && validDoorLocation(board, dest)) {
-            board->setTile(dest, rand() % 3 == 1 ? tileWindow : tileDoorClosed);
+            board->setTile(dest, rng.below(3) == 1 ? tileWindow : tileDoorClosed);
             return;
         }
         theDir = rotateDirection(theDir);
@@ -283,9 +286,9 @@ void trimDeadEnds(Board *board, int trimPercent, Random &rng) {
             Point here(x, y);
             int tile = board->getTile(here);
             if (tile != tileFloor && tile != tileDoorClosed) continue;
-            if ((rand() % 100) > trimPercent) break;
+            if (static_cast<int>(rng.below(100)) > trimPercent) break;
             if (openDirection(board, here) != Dir::None) {
-                if (rand() % 10000 > 3000)  addNewDoor(board, here, rng);
+                if (rng.below(10000) > 3000)  addNewDoor(board, here, rng);
                 else                        doTrimDeadEnd(board, here);
             }
         }
@@ -14,8 +14,8 @@ void mapRandomEnemies(Board *board, Random &rng, const RandomFoeInfo &info) {
         int iterations = 0;
         do {
             ++iterations;
-            here = Point(1 + (rand() % (board->width() - 2)),
-                         1 + (rand() % (board->height() - 2)));
+            here = Point(1 + rng.below(board->width() - 2),
+                         1 + rng.below(board->height() - 2));
         } while (iterations < MAX_ITERATIONS && board->getTile(here) != tileFloor);
 
         if (board->getTile(here) != tileFloor) {
@@ -24,10 +24,9 @@ void mapRandomEnemies(Board *board, Random &rng, const RandomFoeInfo &info) {
             continue;
         }
 
-        int rowId = rng.next32() % info.typeList.size();
+        int rowId = rng.below(info.typeList.size());
         int type = info.typeList[rowId];
-        Actor *actor = new Actor(type);
+        Actor *actor = board->createActor(type, here);
         actor->reset();
-        board->addActor(actor, here);
     }
 }
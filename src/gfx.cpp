@@ -1,13 +1,15 @@
 #include <algorithm>
+#include <cmath>
 #include <iomanip>
 #include <sstream>
-#include <deque>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 
 #include "actor.h"
 #include "gamestate.h"
+#include "gfx_atlas.h"
+#include "gfx_tilelayer.h"
 #include "board.h"
 #include "game.h"
 #include "point.h"
@@ -16,13 +18,12 @@
 #include "config.h"
 #include "logger.h"
 
-void gfx_drawMap(GameState &state, const AnimFrame *frame) {
+void gfx_drawMap(GameState &state) {
     int screenWidth = 0;
     int screenHeight = 0;
     SDL_GetRendererOutputSize(state.renderer, &screenWidth, &screenHeight);
 
-    int tileScale = state.config->getInt("tile_scale", 1);
-    if (tileScale < 1) tileScale = 1;
+    const int tileScale = state.config->settings().tileScale;
     const int scaledTileWidth = tileWidth * tileScale;
     const int scaledTileHeight = tileHeight * tileScale;
 
@@ -39,8 +40,22 @@ void gfx_drawMap(GameState &state, const AnimFrame *frame) {
     int viewX = state.getPlayer()->position.x() - (mapWidthTiles / 2);
     int viewY = state.getPlayer()->position.y() - (mapHeightTiles  / 2);
 
+    if (!state.tileLayer) state.tileLayer = new TileLayer(state.renderer, state.atlas);
+    const bool cachedTiles = state.tileLayer->supported();
+
     SDL_Rect clipRect = { 0, 0, mapWidthPixels, mapHeightPixels };
     SDL_RenderSetClipRect(state.renderer, &clipRect);
+    bool animatedTiles = false;
+    if (cachedTiles) {
+        animatedTiles = state.tileLayer->draw(state.getBoard(), state.animationStep(), viewX, viewY,
+                                              mapWidthTiles, mapHeightTiles, mapOffsetX, mapOffsetY, tileScale);
+    }
+
+    // sprites are batched by atlas page, so the untextured overlays (health
+    // bars, marks, and the cursor) are collected and drawn afterwards
+    SpriteBatch batch(state.renderer, state.atlas);
+    std::vector<SDL_Rect> healthBars, marks;
+    SDL_Rect cursorRect = { 0, 0, 0, 0 };
     for (int y = 0; y < mapHeightTiles; ++y) {
         for (int x = 0; x < mapWidthTiles; ++x) {
             const Point here(viewX + x, viewY + y);
@@ -57,68 +72,79 @@ void gfx_drawMap(GameState &state, const AnimFrame *frame) {
             if (state.getBoard()->isKnown(here)) {
                 int tileHere = state.getBoard()->getTile(here);
 
-                if (tileHere != tileOutOfBounds) {
+                if (!cachedTiles && tileHere != tileOutOfBounds) {
                     const TileInfo &tileInfo = TileInfo::get(tileHere);
                     SDL_Texture *tile = tileInfo.art;
                     if (tileInfo.animLength > 1) {
-                        int frameNumber = (state.framecount / 12) % tileInfo.animLength;
+                        int frameNumber = state.animationStep() % tileInfo.animLength;
                         tile = tileInfo.frames[frameNumber];
+                        animatedTiles = true;
                     }
-                    if (tile) {
-                        if (visible) SDL_SetTextureColorMod(tile, 255, 255, 255);
-                        else         SDL_SetTextureColorMod(tile,  96,  96,  96);
-                        SDL_RenderCopy(state.renderer, tile, nullptr, &texturePosition);
-                    }
+                    batch.draw(tile, texturePosition, visible ? 255 : 96);
                 }
 
                 if (visible) {
                     Actor *actor = state.getBoard()->actorAt(here);
                     Item *item = state.getBoard()->itemAt(here);
                     if (actor) {
-                        SDL_Texture *tile = actor->typeInfo->art;
-                        if (tile) {
-                            SDL_RenderCopy(state.renderer, tile, nullptr, &texturePosition);
-                        }
+                        batch.draw(actor->typeInfo->art, texturePosition);
                         double hpPercent = static_cast<double>(actor->curHealth) / actor->typeInfo->maxHealth;
                         if (hpPercent < 1.0) {
                             SDL_Rect box = texturePosition;
                             box.h = tileScale;
                             box.w *= hpPercent;
-                            SDL_SetRenderDrawColor(state.renderer, 127, 255, 127, SDL_ALPHA_OPAQUE);
-                            SDL_RenderFillRect(state.renderer, &box);
+                            healthBars.push_back(box);
                         }
                     } else if (item) {
-                        SDL_Texture *tile = item->typeInfo->art;
-                        if (tile) {
-                            SDL_RenderCopy(state.renderer, tile, nullptr, &texturePosition);
-                        }
-                    }
-
-                    if (frame) {
-                        auto iter = frame->data.find(here);
-                        if (iter != frame->data.end()) {
-                            SDL_RenderCopy(state.renderer, iter->second, nullptr, &texturePosition);
-                        }
+                        batch.draw(item->typeInfo->art, texturePosition);
                     }
                 }
             }
 
             if (state.getBoard()->at(here).mark) {
-                SDL_Rect markBox = {
+                marks.push_back(SDL_Rect{
                     texturePosition.x + 2,
                     texturePosition.y + 2,
                     8, 8
-                };
-                SDL_SetRenderDrawColor(state.renderer, 63, 63, 196, 63);
-                SDL_RenderFillRect(state.renderer, &markBox);
+                });
             }
 
             if (state.cursor == here) {
-                SDL_SetRenderDrawColor(state.renderer, 255, 255, 255, 255);
-                SDL_RenderDrawRect(state.renderer, &texturePosition);
+                cursorRect = texturePosition;
             }
         }
     }
+
+    // animation sprites may sit between tiles; they show if the tile they're
+    // closest to is visible
+    for (const AnimSprite &sprite : state.animations.sprites()) {
+        const Point nearest(std::lround(sprite.x), std::lround(sprite.y));
+        if (!state.getBoard()->valid(nearest) || !state.getBoard()->isVisible(nearest)) continue;
+        SDL_Rect texturePosition = {
+            static_cast<int>((sprite.x - viewX) * scaledTileWidth) - mapOffsetX,
+            static_cast<int>((sprite.y - viewY) * scaledTileHeight) - mapOffsetY,
+            scaledTileWidth, scaledTileHeight
+        };
+        batch.draw(sprite.texture, texturePosition);
+    }
+    batch.flush();
+    if (animatedTiles) state.requestFrameAt((state.animationStep() + 1) * animStepTime);
+
+    SDL_SetRenderDrawColor(state.renderer, 127, 255, 127, SDL_ALPHA_OPAQUE);
+    if (!healthBars.empty()) {
+        SDL_RenderFillRects(state.renderer, healthBars.data(), healthBars.size());
+        ++gfxDrawCalls;
+    }
+    SDL_SetRenderDrawColor(state.renderer, 63, 63, 196, 63);
+    if (!marks.empty()) {
+        SDL_RenderFillRects(state.renderer, marks.data(), marks.size());
+        ++gfxDrawCalls;
+    }
+    if (cursorRect.w > 0) {
+        SDL_SetRenderDrawColor(state.renderer, 255, 255, 255, 255);
+        SDL_RenderDrawRect(state.renderer, &cursorRect);
+        ++gfxDrawCalls;
+    }
     SDL_RenderSetClipRect(state.renderer, nullptr);
 }
 
@@ -127,8 +153,7 @@ void gfx_drawSidebar(GameState &state) {
     int screenHeight = 0;
     SDL_GetRendererOutputSize(state.renderer, &screenWidth, &screenHeight);
 
-    int tileScale = state.config->getInt("tile_scale", 1);
-    if (tileScale < 1) tileScale = 1;
+    const int tileScale = state.config->settings().tileScale;
     const int scaledTileWidth = tileWidth * tileScale;
     const int scaledTileHeight = tileHeight * tileScale;
 
@@ -157,7 +182,7 @@ void gfx_drawSidebar(GameState &state) {
     const double healthPercent = static_cast<double>(player->curHealth) / static_cast<double>(player->typeInfo->maxHealth);
     const double energyPercent = static_cast<double>(player->curEnergy) / static_cast<double>(player->typeInfo->maxEnergy);
 
-    state.smallFont->out(xPos, yPos, player->name);
+    state.smallFont->out(xPos, yPos, player->details->name);
     yPos += lineHeight;
     gfx_DrawBar(state, xPos, yPos, sidebarWidth - 16, barHeight, healthPercent, Color{127,255,127});
     yPos += barHeight;
@@ -169,10 +194,12 @@ void gfx_drawSidebar(GameState &state) {
     yPos += tinyLineHeight;
     const int statTop = yPos;
 
+    // icons don't overlap the text, so they can be batched separately from it
+    SpriteBatch icons(state.renderer, state.atlas);
     if (state.mapEditTile >= 0) {
         SDL_Rect artPos{ xPos, yPos, 32, 32 };
         const TileInfo &info = TileInfo::get(state.mapEditTile);
-        SDL_RenderCopy(state.renderer, info.art, nullptr, &artPos);
+        icons.draw(info.art, artPos);
         state.tinyFont->out(xPos + 36, yPos, std::to_string(state.mapEditTile));
         yPos += tinyLineHeight;
         state.tinyFont->out(xPos + 36, yPos, info.name);
@@ -183,23 +210,23 @@ void gfx_drawSidebar(GameState &state) {
     } else {
         SDL_Rect artPos{ xPos, yPos, 16, 16 };
         SDL_Texture *swordArt = state.getImage("ui/sword.png");
-        SDL_RenderCopy(state.renderer, swordArt, nullptr, &artPos);
+        icons.draw(swordArt, artPos);
         state.tinyFont->out(xPos + 20, yPos, std::to_string(state.swordLevel));
         yPos += 20; artPos.y += 20;
         swordArt = state.getImage("ui/armour.png");
-        SDL_RenderCopy(state.renderer, swordArt, nullptr, &artPos);
+        icons.draw(swordArt, artPos);
         state.tinyFont->out(xPos + 20, yPos, std::to_string(state.armourLevel));
         yPos += 40; artPos.y += 40;
         swordArt = state.getImage("ui/arrow.png");
-        SDL_RenderCopy(state.renderer, swordArt, nullptr, &artPos);
+        icons.draw(swordArt, artPos);
         state.tinyFont->out(xPos + 20, yPos, std::to_string(state.arrowCount) + "/" + std::to_string(state.arrowCapacity));
         yPos += 20; artPos.y += 20;
         swordArt = state.getImage("ui/bomb.png");
-        SDL_RenderCopy(state.renderer, swordArt, nullptr, &artPos);
+        icons.draw(swordArt, artPos);
         state.tinyFont->out(xPos + 20, yPos, std::to_string(state.bombCount) + "/" + std::to_string(state.bombCapacity));
         yPos += 20; artPos.y += 20;
         swordArt = state.getImage("ui/coin.png");
-        SDL_RenderCopy(state.renderer, swordArt, nullptr, &artPos);
+        icons.draw(swordArt, artPos);
         state.tinyFont->out(xPos + 20, yPos, std::to_string(state.coinCount));
         int firstYPos = yPos + 10;
 
@@ -210,20 +237,21 @@ void gfx_drawSidebar(GameState &state) {
             if (state.subweaponLevel[i] <= 0) continue;
             SDL_Texture *swordArt = state.getImage(state.subweapons[i].artfile);
             artPos.y = yPos;
-            SDL_RenderCopy(state.renderer, swordArt, nullptr, &artPos);
+            icons.draw(swordArt, artPos);
             if (i == SW_BOW) {
                 state.tinyFont->out(xPos2 + 20, yPos, std::to_string(state.subweaponLevel[i]));
             }
             if (i == state.currentSubweapon) {
                 swordArt = state.getImage("ui/subweapon_cursor.png");
                 SDL_Rect cursorRect { xPos2 - 8, yPos, 8, 16 };
-                SDL_RenderCopy(state.renderer, swordArt, nullptr, &cursorRect);
+                icons.draw(swordArt, cursorRect);
             }
             yPos += 20;
         }
         yPos -= 10;
         if (firstYPos > yPos) yPos = firstYPos;
     }
+    icons.flush();
 
     //  ////  ////  ////  ////  ////  ////  ////  ////  ////  ////  ////  ////
     //  MAP AND TIMER INFO
@@ -262,16 +290,9 @@ void gfx_drawSidebar(GameState &state) {
             yPos -= tinyLineHeight;
             wasRule = true;
         } else {
-            std::vector<std::string> lines;
-            std::string text = m.text;
-            wordwrap(text, wrapWidth, lines);
+            const std::vector<std::string> &lines = state.messages.wrapped(i, wrapWidth);
             for (int j = lines.size() - 1; j >= 0; --j) {
-                const std::string &line = lines[j];
-                if (j == 0) {
-                    state.tinyFont->out(xPos, yPos, line, lineColour);
-                } else {
-                    state.tinyFont->out(xPos, yPos, "  " + line, lineColour);
-                }
+                state.tinyFont->out(xPos, yPos, lines[j], lineColour);
                 yPos -= tinyLineHeight;
                 if (yPos < logTop - tinyLineHeight) break;
             }
@@ -316,22 +337,22 @@ void gfx_drawSidebar(GameState &state) {
     }
 
     gfx_VLine(state, mapWidthPixels, 0, mapHeightPixels, uiColor);
-    if (state.showFPS) {
-        std::stringstream ss;
-        ss << "  FPS: " << state.getFPS();
-        state.smallFont->out(0, 0, ss.str().c_str());
-    }
+    if (state.showFPS) gfx_DrawFrameStats(state, 0, 0);
 }
 
 void gfx_doDrawToolTip(GameState &state) {
     if (!state.showTooltip) return;
+    int mouseX, mouseY;
+    SDL_GetMouseState(&mouseX, &mouseY);
+    gfx_drawToolTipAt(state, mouseX, mouseY);
+}
 
+void gfx_drawToolTipAt(GameState &state, int mouseX, int mouseY) {
     int screenWidth = 0;
     int screenHeight = 0;
     SDL_GetRendererOutputSize(state.renderer, &screenWidth, &screenHeight);
 
-    int tileScale = state.config->getInt("tile_scale", 1);
-    if (tileScale < 1) tileScale = 1;
+    const int tileScale = state.config->settings().tileScale;
     const int scaledTileWidth = tileWidth * tileScale;
     const int scaledTileHeight = tileHeight * tileScale;
 
@@ -345,8 +366,6 @@ void gfx_doDrawToolTip(GameState &state) {
     int viewX = state.getPlayer()->position.x() - (mapWidthTiles / 2);
     int viewY = state.getPlayer()->position.y() - (mapHeightTiles  / 2);
 
-    int mouseX, mouseY;
-    SDL_GetMouseState(&mouseX, &mouseY);
     if (mouseX < mapWidthPixels) {
         int mapMouseX = mouseX + mapOffsetX;
         int mapMouseY = mouseY + mapOffsetY;
@@ -375,58 +394,18 @@ void gfx_doDrawToolTip(GameState &state) {
     }
 }
 
-bool repaint(GameState &state, const AnimFrame *frame, bool callPresent) {
-    int screenWidth = 0;
-    int screenHeight = 0;
-    SDL_GetRendererOutputSize(state.renderer, &screenWidth, &screenHeight);
-    const int animDelay = state.config->getInt("anim_delay", 100);
-
-    bool doNextFrame = false;
-    do {
-        bool didFrame = false;
-        SDL_SetRenderDrawColor(state.renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
-        SDL_RenderClear(state.renderer);
-        do {
-            doNextFrame = false;
-            if (state.animationQueue.empty()) {
-                gfx_drawMap(state, nullptr);
-            } else {
-                AnimFrame *frame = &state.animationQueue.front();
-                switch(frame->special) {
-                    case animFrame:
-                        gfx_drawMap(state, frame);
-                        didFrame = true;
-                        break;
-                    case animText:
-                        doNextFrame = true;
-                        state.addMessage(frame->text);
-                        break;
-                    case animRollText:
-                        doNextFrame = true;
-                        state.addInfo(frame->text);
-                        break;
-                    case animDamage:
-                        state.getBoard()->doDamage(state, frame->actor, frame->damageAmount, frame->damageType, frame->text);
-                        break;
-                    default:
-                        doNextFrame = true;
-                        Logger &logger = Logger::getInstance();
-                        logger.error("Unknown animation frame type " + std::to_string(frame->special));
+void repaint(GameState &state, bool callPresent) {
+    state.animations.advance(state);
 
-                }
-                state.animationQueue.pop_front();
-            }
-        } while (doNextFrame);
-        gfx_drawSidebar(state);
-        if (callPresent) gfx_doDrawToolTip(state);
-
-        state.advanceFrame();
-        if (callPresent) SDL_RenderPresent(state.renderer);
-        if (didFrame) {
-            passCommand(state);
-            SDL_Delay(animDelay);
-        }
-    } while (!state.animationQueue.empty());
+    SDL_SetRenderDrawColor(state.renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
+    SDL_RenderClear(state.renderer);
+    ++gfxDrawCalls;
+    gfx_drawMap(state);
+    gfx_drawSidebar(state);
+    if (callPresent) gfx_doDrawToolTip(state);
 
-    return false;
+    // keep drawing frames for as long as something is animating
+    if (!state.animations.empty()) state.requestFrameAt(SDL_GetTicks());
+    state.advanceFrame();
+    if (callPresent) SDL_RenderPresent(state.renderer);
 }
@@ -0,0 +1,186 @@
+#include <algorithm>
+#include <string>
+
+#include <SDL2/SDL.h>
+
+#include "gfx_atlas.h"
+#include "logger.h"
+
+const int atlasPadding = 1;
+
+unsigned gfxDrawCalls = 0;
+
+SpriteAtlas::SpriteAtlas(SDL_Renderer *renderer)
+: mRenderer(renderer)
+{ }
+
+SpriteAtlas::~SpriteAtlas() {
+    clear();
+}
+
+void SpriteAtlas::clear() {
+    for (SDL_Texture *page : mPages) SDL_DestroyTexture(page);
+    mPages.clear();
+    mSprites.clear();
+}
+
+// Pack every texture no larger than atlasMaxSprite in either dimension into
+// pages using simple shelf packing, tallest first.
+void SpriteAtlas::build(const std::vector<SDL_Texture*> &textures) {
+    Logger &log = Logger::getInstance();
+    clear();
+    if (!SDL_RenderTargetSupported(mRenderer)) {
+        log.warn("Renderer lacks render target support; sprites will not be batched.");
+        return;
+    }
+
+    int pageSize = atlasPageSize;
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(mRenderer, &info) == 0) {
+        if (info.max_texture_width > 0 && info.max_texture_width < pageSize)    pageSize = info.max_texture_width;
+        if (info.max_texture_height > 0 && info.max_texture_height < pageSize)  pageSize = info.max_texture_height;
+    }
+
+    struct Entry {
+        SDL_Texture *texture;
+        int w, h;
+    };
+    std::vector<Entry> entries;
+    for (SDL_Texture *texture : textures) {
+        Entry entry{ texture, 0, 0 };
+        if (!texture || SDL_QueryTexture(texture, nullptr, nullptr, &entry.w, &entry.h) != 0) continue;
+        if (entry.w > atlasMaxSprite || entry.h > atlasMaxSprite) continue;
+        entries.push_back(entry);
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) {
+        return a.h > b.h;
+    });
+
+    Uint8 r, g, b, a;
+    SDL_GetRenderDrawColor(mRenderer, &r, &g, &b, &a);
+    SDL_Texture *oldTarget = SDL_GetRenderTarget(mRenderer);
+    SDL_SetRenderDrawColor(mRenderer, 0, 0, 0, SDL_ALPHA_TRANSPARENT);
+
+    SDL_Texture *page = nullptr;
+    int shelfX = 0, shelfY = 0, shelfHeight = 0;
+    for (const Entry &entry : entries) {
+        if (page && shelfX + entry.w > pageSize) {
+            shelfX = 0;
+            shelfY += shelfHeight + atlasPadding;
+            shelfHeight = 0;
+        }
+        if (!page || shelfY + entry.h > pageSize) {
+            page = SDL_CreateTexture(mRenderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, pageSize, pageSize);
+            if (!page) {
+                log.error(std::string("Failed to create sprite atlas page: ") + SDL_GetError());
+                break;
+            }
+            SDL_SetTextureBlendMode(page, SDL_BLENDMODE_BLEND);
+            SDL_SetRenderTarget(mRenderer, page);
+            SDL_RenderClear(mRenderer);
+            ++gfxDrawCalls;
+            mPages.push_back(page);
+            shelfX = shelfY = shelfHeight = 0;
+        }
+
+        Sprite sprite;
+        sprite.page = page;
+        sprite.rect = SDL_Rect{ shelfX, shelfY, entry.w, entry.h };
+        sprite.u0 = static_cast<float>(shelfX) / pageSize;
+        sprite.v0 = static_cast<float>(shelfY) / pageSize;
+        sprite.u1 = static_cast<float>(shelfX + entry.w) / pageSize;
+        sprite.v1 = static_cast<float>(shelfY + entry.h) / pageSize;
+
+        // copy the pixels exactly, including alpha
+        SDL_BlendMode oldMode;
+        SDL_GetTextureBlendMode(entry.texture, &oldMode);
+        SDL_SetTextureBlendMode(entry.texture, SDL_BLENDMODE_NONE);
+        SDL_RenderCopy(mRenderer, entry.texture, nullptr, &sprite.rect);
+        ++gfxDrawCalls;
+        SDL_SetTextureBlendMode(entry.texture, oldMode);
+        mSprites.insert(std::make_pair(entry.texture, sprite));
+
+        shelfX += entry.w + atlasPadding;
+        if (entry.h > shelfHeight) shelfHeight = entry.h;
+    }
+
+    SDL_SetRenderTarget(mRenderer, oldTarget);
+    SDL_SetRenderDrawColor(mRenderer, r, g, b, a);
+    log.info("Packed " + std::to_string(mSprites.size()) + " sprites into "
+             + std::to_string(mPages.size()) + " atlas pages.");
+}
+
+const Sprite* SpriteAtlas::find(SDL_Texture *texture) const {
+    auto iter = mSprites.find(texture);
+    if (iter == mSprites.end()) return nullptr;
+    return &iter->second;
+}
+
+// Must be called before a packed texture is destroyed, as the pointer may be
+// reused for an unrelated texture.
+void SpriteAtlas::remove(SDL_Texture *texture) {
+    mSprites.erase(texture);
+}
+
+unsigned SpriteAtlas::pageCount() const {
+    return mPages.size();
+}
+
+
+SpriteBatch::SpriteBatch(SDL_Renderer *renderer, const SpriteAtlas *atlas)
+: mRenderer(renderer), mAtlas(atlas), mPage(nullptr)
+{ }
+
+SpriteBatch::~SpriteBatch() {
+    flush();
+}
+
+void SpriteBatch::draw(SDL_Texture *texture, const SDL_Rect &dest, Uint8 shade) {
+    if (!texture) return;
+    const Sprite *sprite = mAtlas ? mAtlas->find(texture) : nullptr;
+    if (!sprite) {
+        flush();
+        if (shade != 255) SDL_SetTextureColorMod(texture, shade, shade, shade);
+        SDL_RenderCopy(mRenderer, texture, nullptr, &dest);
+        ++gfxDrawCalls;
+        if (shade != 255) SDL_SetTextureColorMod(texture, 255, 255, 255);
+        return;
+    }
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if (sprite->page != mPage) {
+        flush();
+        mPage = sprite->page;
+    }
+
+    const int first = mVertices.size();
+    const SDL_Color colour = { shade, shade, shade, 255 };
+    const float left = dest.x, top = dest.y;
+    const float right = dest.x + dest.w, bottom = dest.y + dest.h;
+    mVertices.push_back(SDL_Vertex{ SDL_FPoint{ left,  top },    colour, SDL_FPoint{ sprite->u0, sprite->v0 } });
+    mVertices.push_back(SDL_Vertex{ SDL_FPoint{ right, top },    colour, SDL_FPoint{ sprite->u1, sprite->v0 } });
+    mVertices.push_back(SDL_Vertex{ SDL_FPoint{ right, bottom }, colour, SDL_FPoint{ sprite->u1, sprite->v1 } });
+    mVertices.push_back(SDL_Vertex{ SDL_FPoint{ left,  bottom }, colour, SDL_FPoint{ sprite->u0, sprite->v1 } });
+    mIndices.push_back(first);      mIndices.push_back(first + 1);  mIndices.push_back(first + 2);
+    mIndices.push_back(first);      mIndices.push_back(first + 2);  mIndices.push_back(first + 3);
+#else
+    // no geometry API; consecutive copies from the same page still let SDL
+    // batch them internally
+    if (shade != 255) SDL_SetTextureColorMod(sprite->page, shade, shade, shade);
+    SDL_RenderCopy(mRenderer, sprite->page, &sprite->rect, &dest);
+    ++gfxDrawCalls;
+    if (shade != 255) SDL_SetTextureColorMod(sprite->page, 255, 255, 255);
+#endif
+}
+
+void SpriteBatch::flush() {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    if (mPage && !mIndices.empty()) {
+        SDL_RenderGeometry(mRenderer, mPage, mVertices.data(), mVertices.size(), mIndices.data(), mIndices.size());
+        ++gfxDrawCalls;
+    }
+#endif
+    mVertices.clear();
+    mIndices.clear();
+    mPage = nullptr;
+}
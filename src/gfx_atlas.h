@@ -0,0 +1,61 @@
+#ifndef GFX_ATLAS_H
+#define GFX_ATLAS_H
+
+#include <map>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+// Count of draw calls made to the renderer by the map, sprite, text, and UI
+// drawing code. Only ever increases; whoever is measuring resets it.
+extern unsigned gfxDrawCalls;
+
+const int atlasPageSize = 1024;
+const int atlasMaxSprite = 64;
+
+struct Sprite {
+    SDL_Texture *page;
+    SDL_Rect rect;
+    float u0, v0, u1, v1;
+};
+
+// Copies of small textures (tiles, actors, items, effects and icons) packed
+// into a few large pages, so that runs of sprites can be drawn from a single
+// texture. The original textures remain valid and are used as keys.
+class SpriteAtlas {
+public:
+    SpriteAtlas(SDL_Renderer *renderer);
+    ~SpriteAtlas();
+
+    void clear();
+    void build(const std::vector<SDL_Texture*> &textures);
+    const Sprite* find(SDL_Texture *texture) const;
+    void remove(SDL_Texture *texture);
+    unsigned pageCount() const;
+
+private:
+    SDL_Renderer *mRenderer;
+    std::vector<SDL_Texture*> mPages;
+    std::map<SDL_Texture*, Sprite> mSprites;
+};
+
+// Collects sprites that share an atlas page and submits them together. Sprites
+// without an atlas entry are drawn directly. Anything drawn by other means
+// between calls to draw() must be preceded by a flush() to keep draw order.
+class SpriteBatch {
+public:
+    SpriteBatch(SDL_Renderer *renderer, const SpriteAtlas *atlas);
+    ~SpriteBatch();
+
+    void draw(SDL_Texture *texture, const SDL_Rect &dest, Uint8 shade = 255);
+    void flush();
+
+private:
+    SDL_Renderer *mRenderer;
+    const SpriteAtlas *mAtlas;
+    SDL_Texture *mPage;
+    std::vector<SDL_Vertex> mVertices;
+    std::vector<int> mIndices;
+};
+
+#endif
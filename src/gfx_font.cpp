@@ -1,11 +1,18 @@
 #include <SDL2/SDL.h>
 
 #include "gamestate.h"
+#include "gfx_atlas.h"
+
+// strings are laid out once and then reused until the cache grows past this
+// many entries, at which point it is simply emptied
+const unsigned fontLayoutCacheLimit = 512;
 
 Font::Font(SDL_Renderer *renderer, SDL_Texture *texture)
-: mRenderer(renderer), mTexture(texture), mCharWidth(8), mCharHeight(8),
-  mLineSpace(10)
-{ }
+: mRenderer(renderer), mTexture(texture), mScale(1), mCharWidth(8), mCharHeight(8),
+  mLineSpace(10), mTextureWidth(0), mTextureHeight(0)
+{
+    if (mTexture) SDL_QueryTexture(mTexture, nullptr, nullptr, &mTextureWidth, &mTextureHeight);
+}
 
 Font::~Font() {
 }
@@ -33,18 +40,30 @@ int Font::getLineHeight() const {
     return (mCharHeight + mLineSpace) * mScale;
 }
 
-void Font::out(int x, int y, const std::string &text, const Color &defaultColor) {
-    if (!mTexture || !mRenderer) return;
+void Font::clearCache() {
+    mLayouts.clear();
+}
 
-    SDL_SetTextureColorMod(mTexture, defaultColor.r, defaultColor.g, defaultColor.b);
+// Break text into glyphs, resolving newlines and formatting escapes. The
+// result is cached by text and default colour.
+const Font::TextLayout& Font::layout(const std::string &text, const Color &defaultColor) {
+    // the key is built in a reused buffer so that cache hits don't allocate
+    mKey.assign(1, static_cast<char>(defaultColor.r));
+    mKey += static_cast<char>(defaultColor.g);
+    mKey += static_cast<char>(defaultColor.b);
+    mKey += text;
+    auto iter = mLayouts.find(mKey);
+    if (iter != mLayouts.end()) return iter->second;
 
-    SDL_Rect src = { 0, 0, mCharWidth, mCharHeight };
-    SDL_Rect dest = { x, y, getCharWidth(), getCharHeight() };
+    if (mLayouts.size() >= fontLayoutCacheLimit) mLayouts.clear();
+    TextLayout &glyphs = mLayouts[mKey];
+    Color color = defaultColor;
+    int column = 0, line = 0;
     for (std::string::size_type i = 0; i < text.size(); ++i) {
         char c = text[i];
         if (c == '\n') {
-            dest.y += getLineHeight();
-            dest.x = x;
+            ++line;
+            column = 0;
             continue;
         }
         if (c == 27) {
@@ -54,7 +73,7 @@ void Font::out(int x, int y, const std::string &text, const Color &defaultColor)
             int cmd = text[i];
             switch(cmd) {
                 case 1: // reset formatting
-                    SDL_SetTextureColorMod(mTexture, defaultColor.r, defaultColor.g, defaultColor.b);
+                    color = defaultColor;
                     break;
                 case 2: { // set text colour
                     ++i;
@@ -66,13 +85,73 @@ void Font::out(int x, int y, const std::string &text, const Color &defaultColor)
                     ++i;
                     if (i >= text.size()) break;
                     int b = text[i];
-                    SDL_SetTextureColorMod(mTexture, r, g, b);
+                    color = Color{r, g, b};
                     break; }
             }
             continue;
         }
-        src.x = c * mCharWidth;
+        glyphs.push_back(Glyph{ column, line, static_cast<unsigned char>(c), color });
+        ++column;
+    }
+    return glyphs;
+}
+
+void Font::out(int x, int y, const std::string &text, const Color &defaultColor) {
+    if (!mTexture || !mRenderer) return;
+
+    const TextLayout &glyphs = layout(text, defaultColor);
+    if (glyphs.empty()) return;
+    const int charWidth = getCharWidth();
+    const int charHeight = getCharHeight();
+    const int lineHeight = getLineHeight();
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+    // the whole string goes to the renderer as a single piece of geometry, with
+    // colours applied per vertex
+    static std::vector<SDL_Vertex> vertices;
+    static std::vector<int> indices;
+    vertices.clear();
+    indices.clear();
+    const float texWidth = mTextureWidth > 0 ? mTextureWidth : 1;
+    const float texHeight = mTextureHeight > 0 ? mTextureHeight : 1;
+    for (const Glyph &glyph : glyphs) {
+        const float left = x + glyph.column * charWidth;
+        const float top = y + glyph.line * lineHeight;
+        const float right = left + charWidth;
+        const float bottom = top + charHeight;
+        const float u0 = glyph.c * mCharWidth / texWidth;
+        const float u1 = (glyph.c + 1) * mCharWidth / texWidth;
+        const float v1 = mCharHeight / texHeight;
+        const SDL_Color colour = {
+            static_cast<Uint8>(glyph.color.r), static_cast<Uint8>(glyph.color.g),
+            static_cast<Uint8>(glyph.color.b), 255
+        };
+        const int first = vertices.size();
+        vertices.push_back(SDL_Vertex{ SDL_FPoint{ left,  top },    colour, SDL_FPoint{ u0, 0 } });
+        vertices.push_back(SDL_Vertex{ SDL_FPoint{ right, top },    colour, SDL_FPoint{ u1, 0 } });
+        vertices.push_back(SDL_Vertex{ SDL_FPoint{ right, bottom }, colour, SDL_FPoint{ u1, v1 } });
+        vertices.push_back(SDL_Vertex{ SDL_FPoint{ left,  bottom }, colour, SDL_FPoint{ u0, v1 } });
+        indices.push_back(first);   indices.push_back(first + 1);   indices.push_back(first + 2);
+        indices.push_back(first);   indices.push_back(first + 2);   indices.push_back(first + 3);
+    }
+    SDL_SetTextureColorMod(mTexture, 255, 255, 255);
+    SDL_RenderGeometry(mRenderer, mTexture, vertices.data(), vertices.size(), indices.data(), indices.size());
+    ++gfxDrawCalls;
+#else
+    SDL_Rect src = { 0, 0, mCharWidth, mCharHeight };
+    SDL_Rect dest = { x, y, charWidth, charHeight };
+    Color current = glyphs.front().color;
+    SDL_SetTextureColorMod(mTexture, current.r, current.g, current.b);
+    for (const Glyph &glyph : glyphs) {
+        if (glyph.color.r != current.r || glyph.color.g != current.g || glyph.color.b != current.b) {
+            current = glyph.color;
+            SDL_SetTextureColorMod(mTexture, current.r, current.g, current.b);
+        }
+        src.x = glyph.c * mCharWidth;
+        dest.x = x + glyph.column * charWidth;
+        dest.y = y + glyph.line * lineHeight;
         SDL_RenderCopy(mRenderer, mTexture, &src, &dest);
-        dest.x += getCharWidth();
+        ++gfxDrawCalls;
     }
+#endif
 }
@@ -93,15 +93,22 @@ void showVersion(GameState &state) {
             gameVersion);
 }
 
+// The logo is only needed while a menu is up, so it's released when the menu
+// closes.
 int Menu::run(GameState &state) {
+    ImageHandle logo = state.acquireImage("logo.png");
+    int result = runWithLogo(state, state.imageFromHandle(logo));
+    state.releaseImage(logo);
+    return result;
+}
+
+int Menu::runWithLogo(GameState &state, SDL_Texture *logoArt) {
     bool showInfo = false;
     const std::string writeDir = state.config->getString("writeDir", "unknown");
     int screenWidth = 0;
     int screenHeight = 0;
     SDL_GetRendererOutputSize(state.renderer, &screenWidth, &screenHeight);
 
-    SDL_Texture *logoArt = state.getImage("logo.png");
-
     int logoWidth, logoHeight;
     SDL_QueryTexture(logoArt, nullptr, nullptr, &logoWidth, &logoHeight);
 
@@ -162,11 +169,18 @@ int Menu::run(GameState &state) {
         }
 
         showVersion(state);
+        state.pollLoading();
+        if (state.isLoading()) {
+            int done = 0, total = 0;
+            state.getLoadProgress(done, total);
+            std::string text = "Loading assets... " + std::to_string(done) + "/" + std::to_string(total);
+            state.smallFont->out(0, screenHeight - state.smallFont->getLineHeight(), text);
+        }
         state.advanceFrame();
         SDL_RenderPresent(state.renderer);
 
         SDL_Event event;
-        while (SDL_PollEvent(&event)) {
+        while (state.nextEvent(event)) {
             if (event.type == SDL_MOUSEBUTTONUP) {
                 MenuOption &choice = getOptionByCoord(event.button.x, event.button.y);
                 if (choice.code >= 0) {
@@ -281,8 +295,10 @@ void gfx_RunInfo(GameState &state, const std::vector<std::string> &text, bool au
         state.advanceFrame();
         SDL_RenderPresent(state.renderer);
 
+        // only keep drawing while the text is scrolling
+        if (!pauseScroll) state.requestFrameAt(SDL_GetTicks());
         SDL_Event event;
-        if (SDL_PollEvent(&event)) {
+        if (state.nextEvent(event)) {
             const CommandDef &cmd = getCommand(state, event, infoCommands);
             switch(cmd.command) {
                 case Command::Quit:
@@ -5,6 +5,7 @@
 #include <vector>
 
 class GameState;
+struct SDL_Texture;
 
 const int menuNone = -1;
 const int menuQuit = 10000;
@@ -48,6 +49,8 @@ public:
     void previous();
 
 private:
+    int runWithLogo(GameState &state, SDL_Texture *logoArt);
+
     std::vector<MenuOption> options;
     unsigned selected;
 };
@@ -0,0 +1,83 @@
+#include <string>
+
+#include <SDL2/SDL.h>
+
+#include "board.h"
+#include "gfx_minimap.h"
+#include "logger.h"
+
+static Uint32 packColour(int r, int g, int b) {
+    return 0xFF000000u | (r << 16) | (g << 8) | b;
+}
+
+Minimap::Minimap(SDL_Renderer *renderer)
+: mRenderer(renderer)
+{ }
+
+Minimap::~Minimap() {
+    clear();
+}
+
+// Forget every board; must be called when boards are deleted.
+void Minimap::clear() {
+    invalidate();
+    mImages.clear();
+}
+
+// Free the textures (for example, after the render device was reset) so
+// they're recreated by the next update.
+void Minimap::invalidate() {
+    for (auto &iter : mImages) {
+        if (iter.second.texture) SDL_DestroyTexture(iter.second.texture);
+        iter.second.texture = nullptr;
+        iter.second.pixels.clear();
+    }
+}
+
+void Minimap::update(const Board *board) {
+    Image &image = mImages[board];
+    bool redrawAll = false;
+    if (!image.texture || image.width != board->width() || image.height != board->height()) {
+        if (image.texture) SDL_DestroyTexture(image.texture);
+        image.width = board->width();
+        image.height = board->height();
+        image.pixels.assign(image.width * image.height, 0);
+        image.rowVersions.assign(image.height, 0);
+        image.texture = SDL_CreateTexture(mRenderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING,
+                                          image.width, image.height);
+        if (!image.texture) {
+            Logger::getInstance().error(std::string("Failed to create minimap texture: ") + SDL_GetError());
+            return;
+        }
+        redrawAll = true;
+    }
+
+    int firstRow = image.height, lastRow = -1;
+    for (int y = 0; y < image.height; ++y) {
+        const unsigned version = board->rowVersion(y);
+        if (!redrawAll && image.rowVersions[y] == version) continue;
+        image.rowVersions[y] = version;
+        for (int x = 0; x < image.width; ++x) {
+            const Point here(x, y);
+            Uint32 colour = 0;
+            if (board->isKnown(here)) {
+                const TileInfo &info = TileInfo::get(board->getTile(here));
+                if (board->isVisible(here)) colour = packColour(info.red, info.green, info.blue);
+                else                        colour = packColour(info.red / 3, info.green / 3, info.blue / 3);
+            }
+            image.pixels[x + y * image.width] = colour;
+        }
+        if (y < firstRow) firstRow = y;
+        lastRow = y;
+    }
+    if (lastRow < 0) return;
+
+    SDL_Rect rows = { 0, firstRow, image.width, lastRow - firstRow + 1 };
+    SDL_UpdateTexture(image.texture, &rows, &image.pixels[firstRow * image.width], image.width * sizeof(Uint32));
+}
+
+void Minimap::draw(const Board *board, const SDL_Rect &dest) {
+    auto iter = mImages.find(board);
+    if (iter == mImages.end() || !iter->second.texture) return;
+    SDL_RenderCopy(mRenderer, iter->second.texture, nullptr, &dest);
+}
@@ -0,0 +1,37 @@
+#ifndef GFX_MINIMAP_H
+#define GFX_MINIMAP_H
+
+#include <map>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+class Board;
+
+// One pixel per tile overviews of each board, used by the full map screen.
+// Each board's texture is kept between uses and only the rows the board
+// reports as changed (see Board::rowVersion) since the last update are
+// redrawn and uploaded.
+class Minimap {
+public:
+    Minimap(SDL_Renderer *renderer);
+    ~Minimap();
+
+    void clear();
+    void invalidate();
+    void update(const Board *board);
+    void draw(const Board *board, const SDL_Rect &dest);
+
+private:
+    struct Image {
+        SDL_Texture *texture;
+        int width, height;
+        std::vector<Uint32> pixels;
+        std::vector<unsigned> rowVersions;
+    };
+
+    SDL_Renderer *mRenderer;
+    std::map<const Board*, Image> mImages;
+};
+
+#endif
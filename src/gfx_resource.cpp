@@ -5,7 +5,11 @@
 #include <physfs.h>
 #include "physfsrwops.h"
 #include "gamestate.h"
+#include "gfx_atlas.h"
+#include "gfx_tilelayer.h"
+#include "loader.h"
 #include "logger.h"
+#include "textutil.h"
 
 
 const TrackInfo noTrack{-1, "", "no track playing", ""};
@@ -13,22 +17,15 @@ const TrackInfo noTrack{-1, "", "no track playing", ""};
 
 SDL_Texture* GameState::getImageCore(const std::string &name) {
     Logger &log = Logger::getInstance();
-    auto previous = mImages.find(name);
-    if (previous != mImages.end()) return previous->second;
-
-    auto fp = PHYSFS_openRead(name.c_str());
-    if (!fp) {
-        auto err = PHYSFS_getLastErrorCode();
-        log.error(std::string("Failed to load file ") + name + ": " + PHYSFS_getErrorByCode(err));
-        return nullptr;
-    }
-    auto rwops = PHYSFSRWOPS_makeRWops(fp);
 
-    SDL_Surface *surf = IMG_Load_RW(rwops, 0);
-    rwops->close(rwops);
+    SDL_Surface *surf = mLoader ? mLoader->takeImage(name) : nullptr;
     if (!surf) {
-        log.error(std::string("Failed to load image ") + name + ": " + IMG_GetError() + "\n");
-        return nullptr;
+        std::string error;
+        surf = decodeImage(name, error);
+        if (!surf) {
+            log.error(error);
+            return nullptr;
+        }
     }
 
     SDL_Texture *tex = SDL_CreateTextureFromSurface(renderer, surf);
@@ -40,11 +37,145 @@ SDL_Texture* GameState::getImageCore(const std::string &name) {
     return tex;
 }
 
+// Images fetched with getImage are held by the cache until unloadAll; the
+// returned pointer remains valid for that long. Anything only needed for a
+// while should use acquireImage and releaseImage instead.
 SDL_Texture* GameState::getImage(const std::string &name) {
-    std::string fullName("/gfx/");
-    fullName += name;
-    SDL_Texture *tex = getImageCore(fullName);
-    return tex;
+    auto previous = mImages.find(name);
+    if (previous != mImages.end()) {
+        const ImageAsset &asset = mImageAssets[previous->second];
+        if (asset.texture || asset.failed) {
+            ++mAssetStats.hits;
+            return asset.texture;
+        }
+    }
+    return imageFromHandle(acquireImage(name));
+}
+
+// Art for actor, item, and tile types, which is held until the game data is
+// unloaded.
+SDL_Texture* GameState::holdDataImage(const std::string &name) {
+    ImageHandle handle = acquireImage(name);
+    mDataImages.push_back(handle);
+    return imageFromHandle(handle);
+}
+
+ImageHandle GameState::acquireImage(const std::string &name) {
+    ImageHandle handle = noImage;
+    auto previous = mImages.find(name);
+    if (previous != mImages.end()) {
+        handle = previous->second;
+    } else {
+        handle = mImageAssets.size();
+        mImageAssets.push_back(ImageAsset{name, nullptr, 0, 0, false});
+        mImages.insert(std::make_pair(name, handle));
+    }
+
+    ImageAsset &asset = mImageAssets[handle];
+    ++asset.refCount;
+    if (asset.texture || asset.failed) {
+        ++mAssetStats.hits;
+        return handle;
+    }
+
+    ++mAssetStats.misses;
+    asset.texture = getImageCore("/gfx/" + name);
+    if (!asset.texture) {
+        // don't retry (and log) every time a missing image is asked for
+        asset.failed = true;
+        ++mAssetStats.failures;
+        return handle;
+    }
+
+    int width = 0, height = 0;
+    SDL_QueryTexture(asset.texture, nullptr, nullptr, &width, &height);
+    asset.bytes = width * height * 4;
+    mAssetStats.residentBytes += asset.bytes;
+    return handle;
+}
+
+void GameState::releaseImage(ImageHandle handle) {
+    if (handle < 0 || handle >= static_cast<int>(mImageAssets.size())) return;
+    ImageAsset &asset = mImageAssets[handle];
+    if (asset.refCount <= 0) {
+        Logger::getInstance().warn("Released image " + asset.name + " more times than it was acquired.");
+        return;
+    }
+
+    --asset.refCount;
+    if (asset.refCount == 0 && asset.texture) {
+        if (atlas) atlas->remove(asset.texture);
+        SDL_DestroyTexture(asset.texture);
+        asset.texture = nullptr;
+        mAssetStats.residentBytes -= asset.bytes;
+        asset.bytes = 0;
+        ++mAssetStats.evictions;
+    }
+}
+
+SDL_Texture* GameState::imageFromHandle(ImageHandle handle) const {
+    if (handle < 0 || handle >= static_cast<int>(mImageAssets.size())) return nullptr;
+    return mImageAssets[handle].texture;
+}
+
+// Read a list of files, one per line. Blank lines and lines starting with #
+// are ignored. A missing manifest is treated as empty.
+std::vector<std::string> readManifest(const std::string &filename) {
+    std::vector<std::string> names;
+    if (!PHYSFS_exists(filename.c_str())) return names;
+
+    char *text = slurpFile(filename);
+    if (!text) return names;
+    for (const std::string &line : explode(text, "\n")) {
+        if (line.empty() || line[0] == '#') continue;
+        names.push_back(line);
+    }
+    delete[] text;
+    return names;
+}
+
+// Load every image named in the manifest (paths relative to /gfx) so they are
+// resident before play begins.
+bool GameState::preloadImages(const std::string &manifestFile) {
+    Logger &log = Logger::getInstance();
+    if (!PHYSFS_exists(manifestFile.c_str())) {
+        log.info("No image manifest " + manifestFile + "; skipping preload.");
+        return true;
+    }
+
+    std::vector<std::string> names = readManifest(manifestFile);
+    for (const std::string &name : names) {
+        getImage(name);
+    }
+    log.info("Preloaded " + std::to_string(names.size()) + " images.");
+    logAssetStats();
+    return true;
+}
+
+// Pack the small images currently in the cache into atlas pages. Images
+// loaded later are drawn from their own textures.
+void GameState::buildAtlas() {
+    if (!atlas) atlas = new SpriteAtlas(renderer);
+    std::vector<SDL_Texture*> textures;
+    for (const ImageAsset &asset : mImageAssets) {
+        if (asset.texture) textures.push_back(asset.texture);
+    }
+    atlas->build(textures);
+    if (tileLayer) tileLayer->invalidate();
+}
+
+const AssetStats& GameState::getAssetStats() const {
+    return mAssetStats;
+}
+
+void GameState::logAssetStats() const {
+    Logger &log = Logger::getInstance();
+    log.info("Image cache: " + std::to_string(mImageAssets.size()) + " images, "
+             + std::to_string(mAssetStats.residentBytes / 1024) + "KB resident, "
+             + std::to_string(mAssetStats.hits) + " hits, "
+             + std::to_string(mAssetStats.misses) + " misses, "
+             + std::to_string(mAssetStats.failures) + " failures, "
+             + std::to_string(mAssetStats.evictions) + " evictions.");
 }
 
 Mix_Music* GameState::getMusic(const std::string &name) {
@@ -66,24 +197,17 @@ Mix_Music* GameState::getMusic(const std::string &name) {
 }
 
 Mix_Chunk* GameState::getAudio(const std::string &name) {
-    Logger &log = Logger::getInstance();
-
     std::string fullName("/audio/");
     fullName += name;
-    auto fp = PHYSFS_openRead(fullName.c_str());
-    if (!fp) {
-        auto err = PHYSFS_getLastErrorCode();
-        log.error(std::string("Error to load audio file ") + name + ": " + PHYSFS_getErrorByCode(err));
-        return nullptr;
-    }
-    auto rwops = PHYSFSRWOPS_makeRWops(fp);
+    Mix_Chunk *chunk = mLoader ? mLoader->takeAudio(fullName) : nullptr;
+    if (chunk) return chunk;
 
-    Mix_Chunk *surf = Mix_LoadWAV_RW(rwops, 0);
-    rwops->close(rwops);
-    if (!surf) {
-        log.error(std::string("Error loadig audio ") + name + ": " + Mix_GetError());
+    std::string error;
+    chunk = decodeAudio(fullName, error);
+    if (!chunk) {
+        Logger::getInstance().error(error);
     }
-    return surf;
+    return chunk;
 }
 
 Font* GameState::getFont(const std::string &name) {
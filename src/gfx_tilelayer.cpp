@@ -0,0 +1,254 @@
+#include <SDL2/SDL.h>
+
+#include "board.h"
+#include "game.h"
+#include "gfx_atlas.h"
+#include "gfx_tilelayer.h"
+#include "logger.h"
+
+const int dimColour = 96;
+const int keyOutOfBounds = -2;
+const int keyUnknown = -1;
+
+static int floorDiv(int value, int divisor) {
+    if (value < 0) return (value - divisor + 1) / divisor;
+    return value / divisor;
+}
+
+TileLayer::TileLayer(SDL_Renderer *renderer, const SpriteAtlas *atlas)
+: mRenderer(renderer), mAtlas(atlas), mBoard(nullptr), mBoardWidth(0), mBoardHeight(0),
+  mChunksWide(0), mChunksHigh(0), mFrame(0)
+{
+    mSupported = SDL_RenderTargetSupported(renderer);
+    if (!mSupported) {
+        Logger::getInstance().warn("Renderer lacks render target support; map tiles will not be cached.");
+    }
+}
+
+TileLayer::~TileLayer() {
+    for (Chunk &chunk : mChunks) freeChunk(chunk);
+}
+
+bool TileLayer::supported() const {
+    return mSupported;
+}
+
+// Discard every chunk (for example, after the renderer has lost its render
+// targets) so they are all recreated on the next frame.
+void TileLayer::invalidate() {
+    for (Chunk &chunk : mChunks) freeChunk(chunk);
+}
+
+void TileLayer::reset(const Board *board) {
+    for (Chunk &chunk : mChunks) freeChunk(chunk);
+    mBoard = board;
+    mBoardWidth = board->width();
+    mBoardHeight = board->height();
+    mChunksWide = (mBoardWidth + tileChunkSize - 1) / tileChunkSize;
+    mChunksHigh = (mBoardHeight + tileChunkSize - 1) / tileChunkSize;
+    const int tilesPerChunk = tileChunkSize * tileChunkSize;
+    mChunks.assign(mChunksWide * mChunksHigh, Chunk{
+        nullptr, nullptr,
+        std::vector<int>(tilesPerChunk, keyOutOfBounds - 1),
+        std::vector<int>(tilesPerChunk, keyOutOfBounds - 1),
+        0, false
+    });
+}
+
+// Compare what each tile of the chunk should look like with what it looked
+// like when last drawn, updating the stored keys. Returns true if anything
+// changed.
+bool TileLayer::updateKeys(const Board *board, int animFrame, Chunk &chunk, int chunkX, int chunkY) {
+    bool changed = false;
+    chunk.animated = false;
+    for (int y = 0; y < tileChunkSize; ++y) {
+        for (int x = 0; x < tileChunkSize; ++x) {
+            const Point here(chunkX * tileChunkSize + x, chunkY * tileChunkSize + y);
+            int litKey = keyOutOfBounds;
+            int dimKey = keyOutOfBounds;
+            if (board->valid(here)) {
+                int tile = board->getTile(here);
+                const TileInfo &info = TileInfo::get(tile);
+                int frame = 0;
+                if (info.animLength > 1) {
+                    frame = animFrame % info.animLength;
+                    chunk.animated = true;
+                }
+                litKey = tile * 256 + frame;
+                dimKey = board->isKnown(here) ? litKey : keyUnknown;
+            }
+
+            const int index = x + y * tileChunkSize;
+            if (chunk.litKey[index] != litKey || chunk.dimKey[index] != dimKey) {
+                chunk.litKey[index] = litKey;
+                chunk.dimKey[index] = dimKey;
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+void TileLayer::renderChunk(const Board *board, int animFrame, Chunk &chunk, int chunkX, int chunkY) {
+    const int pixelWidth = tileChunkSize * tileWidth;
+    const int pixelHeight = tileChunkSize * tileHeight;
+    if (!chunk.lit) {
+        chunk.lit = SDL_CreateTexture(mRenderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, pixelWidth, pixelHeight);
+        chunk.dim = SDL_CreateTexture(mRenderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, pixelWidth, pixelHeight);
+        if (!chunk.lit || !chunk.dim) {
+            Logger::getInstance().error(std::string("Failed to create map chunk texture: ") + SDL_GetError());
+            freeChunk(chunk);
+            return;
+        }
+        SDL_SetTextureBlendMode(chunk.lit, SDL_BLENDMODE_BLEND);
+        SDL_SetTextureBlendMode(chunk.dim, SDL_BLENDMODE_BLEND);
+    }
+
+    Uint8 r, g, b, a;
+    SDL_GetRenderDrawColor(mRenderer, &r, &g, &b, &a);
+    SDL_Texture *oldTarget = SDL_GetRenderTarget(mRenderer);
+    SDL_SetRenderDrawColor(mRenderer, 0, 0, 0, SDL_ALPHA_TRANSPARENT);
+
+    SpriteBatch batch(mRenderer, mAtlas);
+    for (int variant = 0; variant < 2; ++variant) {
+        const bool dim = variant == 1;
+        SDL_SetRenderTarget(mRenderer, dim ? chunk.dim : chunk.lit);
+        SDL_RenderClear(mRenderer);
+        ++gfxDrawCalls;
+        for (int y = 0; y < tileChunkSize; ++y) {
+            for (int x = 0; x < tileChunkSize; ++x) {
+                const Point here(chunkX * tileChunkSize + x, chunkY * tileChunkSize + y);
+                if (!board->valid(here)) continue;
+                if (dim && !board->isKnown(here)) continue;
+                int tileHere = board->getTile(here);
+                if (tileHere == tileOutOfBounds) continue;
+
+                const TileInfo &tileInfo = TileInfo::get(tileHere);
+                SDL_Texture *tile = tileInfo.art;
+                if (tileInfo.animLength > 1) tile = tileInfo.frames[animFrame % tileInfo.animLength];
+                if (!tile) continue;
+
+                SDL_Rect texturePosition = { x * tileWidth, y * tileHeight, tileWidth, tileHeight };
+                batch.draw(tile, texturePosition, dim ? dimColour : 255);
+            }
+        }
+        batch.flush();
+    }
+
+    SDL_SetRenderTarget(mRenderer, oldTarget);
+    SDL_SetRenderDrawColor(mRenderer, r, g, b, a);
+}
+
+void TileLayer::freeChunk(Chunk &chunk) {
+    if (chunk.lit) SDL_DestroyTexture(chunk.lit);
+    if (chunk.dim) SDL_DestroyTexture(chunk.dim);
+    chunk.lit = chunk.dim = nullptr;
+    chunk.litKey.assign(chunk.litKey.size(), keyOutOfBounds - 1);
+    chunk.dimKey.assign(chunk.dimKey.size(), keyOutOfBounds - 1);
+}
+
+// Release the textures of the least recently drawn chunks until no more than
+// maxResident chunks have textures.
+void TileLayer::evictUnused(unsigned maxResident) {
+    unsigned resident = 0;
+    for (const Chunk &chunk : mChunks) {
+        if (chunk.lit) ++resident;
+    }
+    while (resident > maxResident) {
+        Chunk *oldest = nullptr;
+        for (Chunk &chunk : mChunks) {
+            if (!chunk.lit || chunk.lastUsed == mFrame) continue;
+            if (!oldest || chunk.lastUsed < oldest->lastUsed) oldest = &chunk;
+        }
+        if (!oldest) return;
+        freeChunk(*oldest);
+        --resident;
+    }
+}
+
+// Draw the terrain for the tilesWide x tilesHigh area of board whose top left
+// tile is (viewX, viewY). Tile (viewX, viewY) is drawn at (-offsetX, -offsetY).
+// Returns true if any animated tiles are in view.
+bool TileLayer::draw(const Board *board, int animFrame, int viewX, int viewY, int tilesWide, int tilesHigh,
+                     int offsetX, int offsetY, int scale) {
+    if (!mSupported || !board) return false;
+    if (board != mBoard || board->width() != mBoardWidth || board->height() != mBoardHeight) {
+        reset(board);
+    }
+    ++mFrame;
+
+    const int scaledTileWidth = tileWidth * scale;
+    const int scaledTileHeight = tileHeight * scale;
+    int firstChunkX = floorDiv(viewX, tileChunkSize);
+    int firstChunkY = floorDiv(viewY, tileChunkSize);
+    int lastChunkX = floorDiv(viewX + tilesWide - 1, tileChunkSize);
+    int lastChunkY = floorDiv(viewY + tilesHigh - 1, tileChunkSize);
+    if (firstChunkX < 0)            firstChunkX = 0;
+    if (firstChunkY < 0)            firstChunkY = 0;
+    if (lastChunkX >= mChunksWide)  lastChunkX = mChunksWide - 1;
+    if (lastChunkY >= mChunksHigh)  lastChunkY = mChunksHigh - 1;
+
+    // bring chunks up to date before drawing anything; this switches render
+    // targets
+    unsigned inView = 0;
+    bool animated = false;
+    for (int cy = firstChunkY; cy <= lastChunkY; ++cy) {
+        for (int cx = firstChunkX; cx <= lastChunkX; ++cx) {
+            Chunk &chunk = mChunks[cx + cy * mChunksWide];
+            chunk.lastUsed = mFrame;
+            ++inView;
+            if (updateKeys(board, animFrame, chunk, cx, cy) || !chunk.lit) {
+                renderChunk(board, animFrame, chunk, cx, cy);
+            }
+            if (chunk.animated) animated = true;
+        }
+    }
+    evictUnused(inView * 2);
+
+    // remembered terrain
+    for (int cy = firstChunkY; cy <= lastChunkY; ++cy) {
+        for (int cx = firstChunkX; cx <= lastChunkX; ++cx) {
+            const Chunk &chunk = mChunks[cx + cy * mChunksWide];
+            if (!chunk.dim) continue;
+            SDL_Rect dest = {
+                (cx * tileChunkSize - viewX) * scaledTileWidth - offsetX,
+                (cy * tileChunkSize - viewY) * scaledTileHeight - offsetY,
+                tileChunkSize * scaledTileWidth, tileChunkSize * scaledTileHeight
+            };
+            SDL_RenderCopy(mRenderer, chunk.dim, nullptr, &dest);
+            ++gfxDrawCalls;
+        }
+    }
+
+    // lit terrain, copied in horizontal runs of visible tiles
+    int startX = viewX < 0 ? 0 : viewX;
+    int endX = viewX + tilesWide > mBoardWidth ? mBoardWidth : viewX + tilesWide;
+    int startY = viewY < 0 ? 0 : viewY;
+    int endY = viewY + tilesHigh > mBoardHeight ? mBoardHeight : viewY + tilesHigh;
+    for (int y = startY; y < endY; ++y) {
+        int x = startX;
+        while (x < endX) {
+            if (!board->isVisible(Point(x, y))) {
+                ++x;
+                continue;
+            }
+            const int runStart = x;
+            const int chunkEnd = (x / tileChunkSize + 1) * tileChunkSize;
+            while (x < endX && x < chunkEnd && board->isVisible(Point(x, y))) ++x;
+
+            const Chunk &chunk = mChunks[runStart / tileChunkSize + (y / tileChunkSize) * mChunksWide];
+            if (!chunk.lit) continue;
+            SDL_Rect source = {
+                (runStart % tileChunkSize) * tileWidth, (y % tileChunkSize) * tileHeight,
+                (x - runStart) * tileWidth, tileHeight
+            };
+            SDL_Rect dest = {
+                (runStart - viewX) * scaledTileWidth - offsetX, (y - viewY) * scaledTileHeight - offsetY,
+                (x - runStart) * scaledTileWidth, scaledTileHeight
+            };
+            SDL_RenderCopy(mRenderer, chunk.lit, &source, &dest);
+            ++gfxDrawCalls;
+        }
+    }
+    return animated;
+}
@@ -0,0 +1,53 @@
+#ifndef GFX_TILELAYER_H
+#define GFX_TILELAYER_H
+
+#include <vector>
+
+class Board;
+class SpriteAtlas;
+struct SDL_Renderer;
+struct SDL_Texture;
+
+const int tileChunkSize = 16;
+
+// Caches the terrain of a board as render target textures, each covering
+// tileChunkSize x tileChunkSize tiles. Every chunk has a lit variant (all
+// tiles at full brightness) and a dim variant (only remembered tiles, darkened)
+// and is only redrawn when the tiles, remembered state, or animation frames
+// within it change. The lit variant is copied over the dim one only where the
+// player can currently see.
+class TileLayer {
+public:
+    TileLayer(SDL_Renderer *renderer, const SpriteAtlas *atlas);
+    ~TileLayer();
+
+    bool supported() const;
+    void invalidate();
+    bool draw(const Board *board, int animFrame, int viewX, int viewY, int tilesWide, int tilesHigh,
+              int offsetX, int offsetY, int scale);
+
+private:
+    struct Chunk {
+        SDL_Texture *lit, *dim;
+        std::vector<int> litKey, dimKey;
+        unsigned lastUsed;
+        bool animated;
+    };
+
+    void reset(const Board *board);
+    bool updateKeys(const Board *board, int animFrame, Chunk &chunk, int chunkX, int chunkY);
+    void renderChunk(const Board *board, int animFrame, Chunk &chunk, int chunkX, int chunkY);
+    void freeChunk(Chunk &chunk);
+    void evictUnused(unsigned maxResident);
+
+    SDL_Renderer *mRenderer;
+    const SpriteAtlas *mAtlas;
+    bool mSupported;
+    const Board *mBoard;
+    int mBoardWidth, mBoardHeight;
+    int mChunksWide, mChunksHigh;
+    std::vector<Chunk> mChunks;
+    unsigned mFrame;
+};
+
+#endif
@@ -1,3 +1,5 @@
+#include <iomanip>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <SDL2/SDL.h>
@@ -5,10 +7,12 @@
 #include "command.h"
 #include "game.h"
 #include "gamestate.h"
+#include "gfx_atlas.h"
 #include "textutil.h"
 
 
 bool gfx_Confirm(GameState &state, const std::string &line1, const std::string &line2, bool defaultResult) {
+    if (state.replaying) return defaultResult;
     int screenWidth = 0;
     int screenHeight = 0;
     SDL_GetRendererOutputSize(state.renderer, &screenWidth, &screenHeight);
@@ -39,7 +43,7 @@ bool gfx_Confirm(GameState &state, const std::string &line1, const std::string &
     while (1) {
         int mouseX, mouseY;
         SDL_GetMouseState(&mouseX, &mouseY);
-        repaint(state, nullptr, false);
+        repaint(state, false);
         int topOffset = 8 + gfx_DrawFrame(state, boxX, boxY, boxWidth, boxHeight, "Confirm");
         state.smallFont->out(titleX, topOffset, line1);
         state.smallFont->out(messageX, topOffset + state.smallFont->getCharHeight(), line2);
@@ -98,6 +102,7 @@ bool gfx_Confirm(GameState &state, const std::string &line1, const std::string &
 }
 
 void gfx_Alert(GameState &state, const std::string &line1, const std::string &line2) {
+    if (state.replaying) return;
     int screenWidth = 0;
     int screenHeight = 0;
     SDL_GetRendererOutputSize(state.renderer, &screenWidth, &screenHeight);
@@ -126,7 +131,7 @@ void gfx_Alert(GameState &state, const std::string &line1, const std::string &li
     while (1) {
         int mouseX, mouseY;
         SDL_GetMouseState(&mouseX, &mouseY);
-        repaint(state, nullptr, false);
+        repaint(state, false);
         int topOffset = 8 + gfx_DrawFrame(state, boxX, boxY, boxWidth, boxHeight, "Alert");
         state.smallFont->out(titleX, topOffset, line1);
         state.smallFont->out(messageX, topOffset + state.smallFont->getCharHeight(), line2);
@@ -183,6 +188,7 @@ bool gfx_EditText(GameState &system, const std::string &prompt, std::string &tex
     while (1) {
         SDL_SetRenderDrawColor(system.renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
         SDL_RenderClear(system.renderer);
+        ++gfxDrawCalls;
         gfx_DrawFrame(system, left, top, width, height, "");
         system.smallFont->out(left + textOffset, top + textOffset, prompt);
         system.smallFont->out(inputLeft, top + textOffset, text);
@@ -247,8 +253,10 @@ void gfx_DrawTooltip(GameState &system, int x, int y, const std::string &text) {
     SDL_Rect inner = { x, y, width, height };
     SDL_SetRenderDrawColor(system.renderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
     SDL_RenderFillRect(system.renderer, &outer);
+    ++gfxDrawCalls;
     SDL_SetRenderDrawColor(system.renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
     SDL_RenderFillRect(system.renderer, &inner);
+    ++gfxDrawCalls;
     system.tinyFont->out(x + offset, y + offset, text);
 }
 
@@ -264,14 +272,17 @@ int gfx_DrawFrame(GameState &system, int x, int y, int w, int h, const std::stri
     SDL_Rect background = { x, y, w, h };
     SDL_SetRenderDrawColor(system.renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
     SDL_RenderFillRect(system.renderer, &background);
+    ++gfxDrawCalls;
     SDL_SetRenderDrawColor(system.renderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
     SDL_RenderDrawRect(system.renderer, &background);
+    ++gfxDrawCalls;
     int lineY = y;
     if (!title.empty()) {
         SDL_Rect titleBar{ x, y, w, system.smallFont->getCharHeight() + 8 };
         int offsetX = (w - title.size() * system.smallFont->getCharWidth()) / 2;
         SDL_SetRenderDrawColor(system.renderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
         SDL_RenderFillRect(system.renderer, &titleBar);
+        ++gfxDrawCalls;
         system.smallFont->out(x + offsetX + 4, y + 4, title, Color{0, 0, 0});
         lineY += titleBar.h;
     }
@@ -282,15 +293,18 @@ void gfx_DrawBar(GameState &system, int x, int y, int length, int height, double
     SDL_Rect dest = { x, y, length, height };
     SDL_SetRenderDrawColor(system.renderer, baseColor.r/2, baseColor.g/2, baseColor.b/2, SDL_ALPHA_OPAQUE);
     SDL_RenderFillRect(system.renderer, &dest);
+    ++gfxDrawCalls;
     dest.x += 2;
     dest.y += 2;
     dest.w -= 4;
     dest.h -= 4;
     SDL_SetRenderDrawColor(system.renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
     SDL_RenderFillRect(system.renderer, &dest);
+    ++gfxDrawCalls;
     dest.w *= percent;
     SDL_SetRenderDrawColor(system.renderer, baseColor.r, baseColor.g, baseColor.b, SDL_ALPHA_OPAQUE);
     SDL_RenderFillRect(system.renderer, &dest);
+    ++gfxDrawCalls;
 }
 
 void gfx_DrawButton(GameState &system, const SDL_Rect &box, bool selected, const std::string &text) {
@@ -298,8 +312,10 @@ void gfx_DrawButton(GameState &system, const SDL_Rect &box, bool selected, const
     if (selected)   SDL_SetRenderDrawColor(system.renderer, 63, 63, 63, SDL_ALPHA_OPAQUE);
     else            SDL_SetRenderDrawColor(system.renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
     SDL_RenderFillRect(system.renderer, &box);
+    ++gfxDrawCalls;
     SDL_SetRenderDrawColor(system.renderer, 255, 255, 255, SDL_ALPHA_OPAQUE);
     SDL_RenderDrawRect(system.renderer, &box);
+    ++gfxDrawCalls;
     const int offset = (box.w - text.size() * charWidth) / 2;
     system.smallFont->out(box.x + offset, box.y + 4, text);
 }
@@ -308,10 +324,67 @@ void gfx_HLine(GameState &system, int x, int x2, int y, const Color &color) {
     SDL_Rect box = {x, y, x2 - x, 1 };
     SDL_SetRenderDrawColor(system.renderer, color.r, color.g, color.b, SDL_ALPHA_OPAQUE);
     SDL_RenderFillRect(system.renderer, &box);
+    ++gfxDrawCalls;
 }
 
 void gfx_VLine(GameState &system, int x, int y, int y2, const Color &color) {
     SDL_Rect box = {x, y, 1, y2 - y };
     SDL_SetRenderDrawColor(system.renderer, color.r, color.g, color.b, SDL_ALPHA_OPAQUE);
     SDL_RenderFillRect(system.renderer, &box);
+    ++gfxDrawCalls;
+}
+
+// The FPS overlay: frame time percentiles and a graph of recent frame times,
+// with a line at the target frame time. Frames over the target are red.
+void gfx_DrawFrameStats(GameState &system, int x, int y) {
+    const FrameSummary summary = system.frameStats.summarize();
+    std::stringstream line;
+    line << std::fixed << std::setprecision(1);
+    line << "  FPS: " << system.getFPS() << "  min " << summary.min << "  p50 " << summary.p50;
+    line << "  p95 " << summary.p95 << "  p99 " << summary.p99 << "  max " << summary.max << " ms";
+    system.smallFont->out(x, y, line.str());
+
+    const int graphTop = y + system.smallFont->getLineHeight();
+    const int graphHeight = 64;
+    const double pixelsPerMs = 2.0;
+    const double targetMs = 1000.0 / targetFrameRate;
+    const SDL_Rect graphArea = {
+        x, graphTop, static_cast<int>(frameHistory) * 2, graphHeight
+    };
+    SDL_SetRenderDrawBlendMode(system.renderer, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(system.renderer, 0, 0, 0, 160);
+    SDL_RenderFillRect(system.renderer, &graphArea);
+    ++gfxDrawCalls;
+    SDL_SetRenderDrawBlendMode(system.renderer, SDL_BLENDMODE_NONE);
+
+    std::vector<SDL_Rect> fast, slow;
+    const FrameStats &stats = system.frameStats;
+    for (unsigned i = 0; i < stats.size(); ++i) {
+        const double ms = stats.at(i);
+        int height = ms * pixelsPerMs;
+        if (height > graphHeight) height = graphHeight;
+        if (height < 1) height = 1;
+        SDL_Rect bar = { x + static_cast<int>(i) * 2, graphTop + graphHeight - height, 2, height };
+        if (ms > targetMs + 1.0)    slow.push_back(bar);
+        else                        fast.push_back(bar);
+    }
+    SDL_SetRenderDrawColor(system.renderer, 63, 196, 63, SDL_ALPHA_OPAQUE);
+    if (!fast.empty()) {
+        SDL_RenderFillRects(system.renderer, fast.data(), fast.size());
+        ++gfxDrawCalls;
+    }
+    SDL_SetRenderDrawColor(system.renderer, 220, 63, 63, SDL_ALPHA_OPAQUE);
+    if (!slow.empty()) {
+        SDL_RenderFillRects(system.renderer, slow.data(), slow.size());
+        ++gfxDrawCalls;
+    }
+
+    const int targetY = graphTop + graphHeight - static_cast<int>(targetMs * pixelsPerMs);
+    gfx_HLine(system, x, x + graphArea.w, targetY, Color{255, 255, 255});
+
+    const AssetStats &assets = system.getAssetStats();
+    std::stringstream cacheLine;
+    cacheLine << "  Images: " << assets.residentBytes / 1024 << "KB  hits " << assets.hits;
+    cacheLine << "  misses " << assets.misses << "  evictions " << assets.evictions;
+    system.smallFont->out(x, graphTop + graphHeight, cacheLine.str());
 }
@@ -0,0 +1,347 @@
+#include <algorithm>
+
+#include "board.h"
+#include "gamestate.h"
+#include "journal.h"
+
+static_assert(playerStatCount == 8 + SW_COUNT, "journal player stats don't match GameState");
+
+static ActorState actorState(const Actor &actor) {
+    return ActorState{
+        actor.id, actor.typeIdent, actor.position, actor.level, actor.xp,
+        actor.curHealth, actor.curEnergy, actor.nextAction,
+        actor.ai_lastDir, actor.ai_lastTarget, actor.ai_pathNext
+    };
+}
+
+static void setActorState(Actor &actor, const ActorState &actorState) {
+    actor.position = actorState.position;
+    actor.level = actorState.level;
+    actor.xp = actorState.xp;
+    actor.curHealth = actorState.curHealth;
+    actor.curEnergy = actorState.curEnergy;
+    actor.nextAction = actorState.nextAction;
+    actor.ai_lastDir = actorState.ai_lastDir;
+    actor.ai_lastTarget = actorState.ai_lastTarget;
+    actor.ai_pathNext = actorState.ai_pathNext;
+}
+
+// the parts of an actor's details worth bringing back with it; remembered
+// paths are left out
+static ActorDetails actorDetails(const Actor &actor) {
+    ActorDetails details;
+    details.name = actor.details->name;
+    details.talkFunc = actor.details->talkFunc;
+    details.talkArg = actor.details->talkArg;
+    details.hasProperName = actor.details->hasProperName;
+    return details;
+}
+
+static void setActorDetails(Actor &actor, const ActorDetails &details) {
+    actor.details->name = details.name;
+    actor.details->talkFunc = details.talkFunc;
+    actor.details->talkArg = details.talkArg;
+    actor.details->hasProperName = details.hasProperName;
+}
+
+static bool sameState(const ActorState &left, const ActorState &right) {
+    return left.type == right.type && left.position == right.position
+        && left.level == right.level && left.xp == right.xp
+        && left.curHealth == right.curHealth && left.curEnergy == right.curEnergy
+        && left.nextAction == right.nextAction && left.ai_lastDir == right.ai_lastDir
+        && left.ai_lastTarget == right.ai_lastTarget && left.ai_pathNext == right.ai_pathNext;
+}
+
+static bool actorLess(const ActorState &left, const ActorState &right) {
+    return left.id < right.id;
+}
+
+// items have no identity of their own, so they're compared by everything
+// about them
+static bool itemLess(const ItemState &left, const ItemState &right) {
+    if (left.itemDef != right.itemDef) return left.itemDef < right.itemDef;
+    if (left.position.x() != right.position.x()) return left.position.x() < right.position.x();
+    if (left.position.y() != right.position.y()) return left.position.y() < right.position.y();
+    return left.fromLocation < right.fromLocation;
+}
+
+static PlayerStats playerStats(const GameState &state) {
+    PlayerStats stats;
+    unsigned n = 0;
+    stats[n++] = state.swordLevel;
+    stats[n++] = state.armourLevel;
+    for (int i = 0; i < SW_COUNT; ++i) stats[n++] = state.subweaponLevel[i];
+    stats[n++] = state.arrowCount;
+    stats[n++] = state.bombCount;
+    stats[n++] = state.coinCount;
+    stats[n++] = state.arrowCapacity;
+    stats[n++] = state.bombCapacity;
+    stats[n++] = state.currentSubweapon;
+    return stats;
+}
+
+static void setPlayerStats(GameState &state, const PlayerStats &stats) {
+    unsigned n = 0;
+    state.swordLevel = stats[n++];
+    state.armourLevel = stats[n++];
+    for (int i = 0; i < SW_COUNT; ++i) state.subweaponLevel[i] = stats[n++];
+    state.arrowCount = stats[n++];
+    state.bombCount = stats[n++];
+    state.coinCount = stats[n++];
+    state.arrowCapacity = stats[n++];
+    state.bombCapacity = stats[n++];
+    state.currentSubweapon = stats[n++];
+}
+
+static RandomStates randomStates(const GameState &state) {
+    RandomStates states;
+    state.mapRNG.getState(&states[0]);
+    state.aiRNG.getState(&states[2]);
+    state.lootRNG.getState(&states[4]);
+    state.combatRNG.getState(&states[6]);
+    return states;
+}
+
+static void setRandomStates(GameState &state, const RandomStates &states) {
+    state.mapRNG.setState(&states[0]);
+    state.aiRNG.setState(&states[2]);
+    state.lootRNG.setState(&states[4]);
+    state.combatRNG.setState(&states[6]);
+}
+
+static void boardActors(GameState &state, std::vector<ActorState> &actors) {
+    actors.clear();
+    for (const Actor *actor : state.getBoard()->getActors()) {
+        actors.push_back(actorState(*actor));
+    }
+    std::sort(actors.begin(), actors.end(), actorLess);
+}
+
+static void boardItems(GameState &state, std::vector<ItemState> &items) {
+    items.clear();
+    for (const Item *item : state.getBoard()->getItems()) {
+        const int itemDef = item->typeInfo - state.itemDefs.data();
+        items.push_back(ItemState{ itemDef, item->position, item->fromLocation });
+    }
+    std::sort(items.begin(), items.end(), itemLess);
+}
+
+Journal::Journal()
+: mFirst(0), mCount(0), mApplied(0), mBoard(nullptr), mTurn(0), mTime(0)
+{ }
+
+// Changing the capacity throws away anything already recorded.
+void Journal::setCapacity(unsigned turns) {
+    if (turns == mRecords.size()) return;
+    if (mBoard) mBoard->setTileLogging(false);
+    mRecords.clear();
+    mRecords.resize(turns);
+    clear();
+}
+
+// Forget everything recorded; the next turn starts a new journal. This
+// doesn't touch the board, since it's called when the boards are about to go.
+void Journal::clear() {
+    mFirst = mCount = mApplied = 0;
+    mBoard = nullptr;
+}
+
+// Called at the end of every turn to record what it changed.
+void Journal::endTurn(GameState &state) {
+    Board *board = state.getBoard();
+    if (mRecords.empty() || !board) return;
+    if (board != mBoard) {
+        if (mBoard) mBoard->setTileLogging(false);
+        mFirst = mCount = mApplied = 0;
+        capture(state);
+        return;
+    }
+
+    // anything that was rewound can't be redone once a new turn is taken
+    mCount = mApplied;
+    if (mCount == mRecords.size()) {
+        mFirst = (mFirst + 1) % mRecords.size();
+        --mCount;
+    }
+    TurnRecord &record = mRecords[(mFirst + mCount) % mRecords.size()];
+    ++mCount;
+    mApplied = mCount;
+
+    record.turnBefore = mTurn;
+    record.turnAfter = state.turnNumber;
+    record.timeBefore = mTime;
+    record.timeAfter = board->getTime();
+    record.rngBefore = mRandom;
+    record.rngAfter = randomStates(state);
+    record.statsBefore = mStats;
+    record.statsAfter = playerStats(state);
+    record.tiles.clear();
+    record.tiles.swap(board->getTileLog());
+    record.actors.clear();
+    record.items.clear();
+    record.locations.clear();
+
+    std::vector<ActorState> actors;
+    boardActors(state, actors);
+    unsigned i = 0, j = 0;
+    while (i < mActors.size() || j < actors.size()) {
+        if (j >= actors.size() || (i < mActors.size() && mActors[i].id < actors[j].id)) {
+            // the actor is gone by now, so its details come from the last
+            // time it was seen
+            record.actors.push_back(TurnRecord::ActorChange{ true, false, mActors[i], mActors[i], mDetails[mActors[i].id] });
+            mDetails.erase(mActors[i].id);
+            ++i;
+        } else if (i >= mActors.size() || actors[j].id < mActors[i].id) {
+            const Actor *actor = board->actorById(actors[j].id);
+            record.actors.push_back(TurnRecord::ActorChange{ false, true, actors[j], actors[j], actorDetails(*actor) });
+            mDetails[actors[j].id] = record.actors.back().details;
+            ++j;
+        } else {
+            if (!sameState(mActors[i], actors[j])) {
+                record.actors.push_back(TurnRecord::ActorChange{ true, true, mActors[i], actors[j] });
+            }
+            ++i;
+            ++j;
+        }
+    }
+    mActors.swap(actors);
+
+    std::vector<ItemState> items;
+    boardItems(state, items);
+    i = j = 0;
+    while (i < mItems.size() || j < items.size()) {
+        if (j >= items.size() || (i < mItems.size() && itemLess(mItems[i], items[j]))) {
+            record.items.push_back(TurnRecord::ItemChange{ false, mItems[i] });
+            ++i;
+        } else if (i >= mItems.size() || itemLess(items[j], mItems[i])) {
+            record.items.push_back(TurnRecord::ItemChange{ true, items[j] });
+            ++j;
+        } else {
+            ++i;
+            ++j;
+        }
+    }
+    mItems.swap(items);
+
+    for (unsigned k = 0; k < state.itemLocations.size() && k < mLocations.size(); ++k) {
+        if (state.itemLocations[k].used == mLocations[k]) continue;
+        record.locations.push_back(k);
+        mLocations[k] = state.itemLocations[k].used;
+    }
+
+    mTurn = record.turnAfter;
+    mTime = record.timeAfter;
+    mRandom = record.rngAfter;
+    mStats = record.statsAfter;
+}
+
+// Step back through up to turns recorded turns, returning how many it could.
+int Journal::rewind(GameState &state, int turns) {
+    if (!mBoard || state.getBoard() != mBoard) return 0;
+    int done = 0;
+    while (done < turns && mApplied > 0) {
+        apply(state, mRecords[(mFirst + mApplied - 1) % mRecords.size()], false);
+        --mApplied;
+        ++done;
+    }
+    if (done > 0) capture(state);
+    return done;
+}
+
+// Play forward again through turns that were rewound.
+int Journal::redo(GameState &state, int turns) {
+    if (!mBoard || state.getBoard() != mBoard) return 0;
+    int done = 0;
+    while (done < turns && mApplied < mCount) {
+        apply(state, mRecords[(mFirst + mApplied) % mRecords.size()], true);
+        ++mApplied;
+        ++done;
+    }
+    if (done > 0) capture(state);
+    return done;
+}
+
+// Remember how things are now so the next turn can be compared with it.
+void Journal::capture(GameState &state) {
+    mBoard = state.getBoard();
+    mBoard->setTileLogging(true);
+    mTurn = state.turnNumber;
+    mTime = mBoard->getTime();
+    mRandom = randomStates(state);
+    mStats = playerStats(state);
+    boardActors(state, mActors);
+    mDetails.clear();
+    for (const Actor *actor : mBoard->getActors()) {
+        mDetails[actor->id] = actorDetails(*actor);
+    }
+    boardItems(state, mItems);
+    mLocations.resize(state.itemLocations.size());
+    for (unsigned i = 0; i < state.itemLocations.size(); ++i) {
+        mLocations[i] = state.itemLocations[i].used;
+    }
+}
+
+void Journal::apply(GameState &state, const TurnRecord &record, bool forward) {
+    Board *board = state.getBoard();
+    board->setTileLogging(false);
+
+    if (forward) {
+        for (const TileChange &change : record.tiles) {
+            board->setTile(change.where, change.after);
+        }
+    } else {
+        for (auto iter = record.tiles.rbegin(); iter != record.tiles.rend(); ++iter) {
+            board->setTile(iter->where, iter->before);
+        }
+    }
+
+    for (const TurnRecord::ItemChange &change : record.items) {
+        const ItemState &item = change.item;
+        if (change.added == forward) {
+            Item *newItem = new Item(&state.itemDefs[item.itemDef], item.fromLocation);
+            board->addItem(newItem, item.position);
+        } else {
+            for (Item *existing : board->getItems()) {
+                if (existing->typeInfo == &state.itemDefs[item.itemDef]
+                        && existing->position == item.position
+                        && existing->fromLocation == item.fromLocation) {
+                    board->removeAndDeleteItem(existing);
+                    break;
+                }
+            }
+        }
+    }
+
+    for (const TurnRecord::ActorChange &change : record.actors) {
+        const bool exists = forward ? change.after : change.before;
+        const ActorState &target = forward ? change.now : change.was;
+        Actor *actor = board->actorById(target.id);
+        if (!exists) {
+            if (!actor) continue;
+            if (actor->isPlayer) board->removeActor(actor);
+            else                 board->destroyActor(actor);
+            continue;
+        }
+        if (!actor) {
+            if (target.id == playerActorId) {
+                actor = state.getPlayer();
+                board->addActor(actor, target.position);
+            } else {
+                actor = board->createActor(target.type, target.position);
+                actor->id = target.id;
+                setActorDetails(*actor, change.details);
+            }
+        }
+        setActorState(*actor, target);
+    }
+    board->rebuildSchedule();
+    board->setTime(forward ? record.timeAfter : record.timeBefore);
+
+    for (unsigned location : record.locations) {
+        state.itemLocations[location].used = !state.itemLocations[location].used;
+    }
+    setPlayerStats(state, forward ? record.statsAfter : record.statsBefore);
+    setRandomStates(state, forward ? record.rngAfter : record.rngBefore);
+    state.turnNumber = forward ? record.turnAfter : record.turnBefore;
+    board->calcFOV(state.getPlayer()->position);
+}
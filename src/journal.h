@@ -0,0 +1,104 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "actor.h"
+#include "point.h"
+
+class Board;
+class GameState;
+
+// the actor state the journal tracks; ids are only unique within a board,
+// except for the player's
+struct ActorState {
+    unsigned id;
+    int type;
+    Point position;
+    int level, xp;
+    int curHealth, curEnergy;
+    int nextAction;
+    Dir ai_lastDir;
+    Point ai_lastTarget;
+    int ai_pathNext;
+};
+
+struct ItemState {
+    int itemDef;
+    Point position;
+    int fromLocation;
+};
+
+struct TileChange {
+    Point where;
+    int before, after;
+};
+
+// sword and armour levels, subweapon levels, ammo and capacities, coins, and
+// the current subweapon
+const unsigned playerStatCount = 14;
+typedef std::array<int, playerStatCount> PlayerStats;
+typedef std::array<std::uint64_t, 8> RandomStates;
+
+// Everything that changed over one turn, with values from both before and
+// after so that it can be undone and then done again.
+struct TurnRecord {
+    // details are only filled in for actors that appear or disappear
+    struct ActorChange {
+        bool before, after;
+        ActorState was, now;
+        ActorDetails details;
+    };
+    struct ItemChange {
+        bool added;
+        ItemState item;
+    };
+
+    int turnBefore, turnAfter;
+    int timeBefore, timeAfter;
+    RandomStates rngBefore, rngAfter;
+    PlayerStats statsBefore, statsAfter;
+    std::vector<TileChange> tiles;
+    std::vector<ActorChange> actors;
+    std::vector<ItemChange> items;
+    std::vector<unsigned> locations;
+};
+
+// A record of the last few turns on the current board, kept in a ring buffer
+// so that they can be stepped back through and forward again when debugging.
+// Turns are recorded by comparing the board with how it was after the last
+// one, so the cost depends on how much is on the board and the memory used
+// on how much changed. Changing board or loading a game starts it over.
+class Journal {
+public:
+    Journal();
+
+    void setCapacity(unsigned turns);
+    bool enabled() const {
+        return !mRecords.empty();
+    }
+    void clear();
+    void endTurn(GameState &state);
+    int rewind(GameState &state, int turns);
+    int redo(GameState &state, int turns);
+
+private:
+    void capture(GameState &state);
+    void apply(GameState &state, const TurnRecord &record, bool forward);
+
+    std::vector<TurnRecord> mRecords;
+    unsigned mFirst, mCount, mApplied;
+    Board *mBoard;
+    int mTurn, mTime;
+    RandomStates mRandom;
+    PlayerStats mStats;
+    std::vector<ActorState> mActors;
+    std::map<unsigned, ActorDetails> mDetails;
+    std::vector<ItemState> mItems;
+    std::vector<bool> mLocations;
+};
+
+#endif
@@ -0,0 +1,153 @@
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <SDL2/SDL_mixer.h>
+
+#include <physfs.h>
+#include "physfsrwops.h"
+#include "loader.h"
+#include "logger.h"
+
+const int maxLoaderThreads = 16;
+
+
+SDL_Surface* decodeImage(const std::string &filename, std::string &error) {
+    auto fp = PHYSFS_openRead(filename.c_str());
+    if (!fp) {
+        auto err = PHYSFS_getLastErrorCode();
+        error = std::string("Failed to load file ") + filename + ": " + PHYSFS_getErrorByCode(err);
+        return nullptr;
+    }
+    auto rwops = PHYSFSRWOPS_makeRWops(fp);
+
+    SDL_Surface *surf = IMG_Load_RW(rwops, 0);
+    rwops->close(rwops);
+    if (!surf) {
+        error = std::string("Failed to load image ") + filename + ": " + IMG_GetError();
+    }
+    return surf;
+}
+
+Mix_Chunk* decodeAudio(const std::string &filename, std::string &error) {
+    auto fp = PHYSFS_openRead(filename.c_str());
+    if (!fp) {
+        auto err = PHYSFS_getLastErrorCode();
+        error = std::string("Error to load audio file ") + filename + ": " + PHYSFS_getErrorByCode(err);
+        return nullptr;
+    }
+    auto rwops = PHYSFSRWOPS_makeRWops(fp);
+
+    Mix_Chunk *chunk = Mix_LoadWAV_RW(rwops, 0);
+    rwops->close(rwops);
+    if (!chunk) {
+        error = std::string("Error loadig audio ") + filename + ": " + Mix_GetError();
+    }
+    return chunk;
+}
+
+
+AssetLoader::AssetLoader() {
+    SDL_AtomicSet(&mNextJob, 0);
+    SDL_AtomicSet(&mCompleted, 0);
+}
+
+AssetLoader::~AssetLoader() {
+    wait();
+    for (LoadJob &job : mJobs) {
+        if (job.surface)    SDL_FreeSurface(job.surface);
+        if (job.chunk)      Mix_FreeChunk(job.chunk);
+    }
+}
+
+void AssetLoader::addImage(const std::string &filename) {
+    if (!mThreads.empty() || mIndex.count(filename)) return;
+    mIndex.insert(std::make_pair(filename, mJobs.size()));
+    mJobs.push_back(LoadJob{jobImage, filename, nullptr, nullptr, ""});
+}
+
+void AssetLoader::addAudio(const std::string &filename) {
+    if (!mThreads.empty() || mIndex.count(filename)) return;
+    mIndex.insert(std::make_pair(filename, mJobs.size()));
+    mJobs.push_back(LoadJob{jobAudio, filename, nullptr, nullptr, ""});
+}
+
+void AssetLoader::start() {
+    if (!mThreads.empty()) return;
+
+    int threadCount = SDL_GetCPUCount();
+    if (threadCount > maxLoaderThreads)                 threadCount = maxLoaderThreads;
+    if (threadCount > static_cast<int>(mJobs.size()))   threadCount = mJobs.size();
+    for (int i = 0; i < threadCount; ++i) {
+        SDL_Thread *thread = SDL_CreateThread(workerMain, "AssetLoader", this);
+        if (thread) mThreads.push_back(thread);
+    }
+
+    if (mThreads.empty()) {
+        // no threads available; decode everything here instead
+        Logger::getInstance().warn(std::string("Failed to start asset loader threads: ") + SDL_GetError());
+        workerMain(this);
+    } else {
+        Logger::getInstance().info("Decoding " + std::to_string(mJobs.size()) + " assets on "
+                                   + std::to_string(mThreads.size()) + " threads.");
+    }
+}
+
+// Jobs are handed out one at a time from a shared counter, so a single slow
+// asset doesn't hold up a whole share of the queue.
+int AssetLoader::workerMain(void *data) {
+    AssetLoader *loader = static_cast<AssetLoader*>(data);
+    const int jobCount = loader->mJobs.size();
+    while (1) {
+        int index = SDL_AtomicAdd(&loader->mNextJob, 1);
+        if (index >= jobCount) break;
+
+        LoadJob &job = loader->mJobs[index];
+        if (job.type == jobImage)   job.surface = decodeImage(job.filename, job.error);
+        else                        job.chunk = decodeAudio(job.filename, job.error);
+        SDL_AtomicAdd(&loader->mCompleted, 1);
+    }
+    return 0;
+}
+
+bool AssetLoader::isDone() {
+    return completed() >= total();
+}
+
+void AssetLoader::wait() {
+    for (SDL_Thread *thread : mThreads) {
+        SDL_WaitThread(thread, nullptr);
+    }
+    mThreads.clear();
+}
+
+int AssetLoader::completed() {
+    return SDL_AtomicGet(&mCompleted);
+}
+
+int AssetLoader::total() const {
+    return mJobs.size();
+}
+
+SDL_Surface* AssetLoader::takeImage(const std::string &filename) {
+    auto iter = mIndex.find(filename);
+    if (iter == mIndex.end() || !isDone()) return nullptr;
+    LoadJob &job = mJobs[iter->second];
+    SDL_Surface *surface = job.surface;
+    job.surface = nullptr;
+    return surface;
+}
+
+Mix_Chunk* AssetLoader::takeAudio(const std::string &filename) {
+    auto iter = mIndex.find(filename);
+    if (iter == mIndex.end() || !isDone()) return nullptr;
+    LoadJob &job = mJobs[iter->second];
+    Mix_Chunk *chunk = job.chunk;
+    job.chunk = nullptr;
+    return chunk;
+}
+
+void AssetLoader::logErrors() const {
+    Logger &log = Logger::getInstance();
+    for (const LoadJob &job : mJobs) {
+        if (!job.error.empty()) log.error(job.error);
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+struct Mix_Chunk;
+
+const int jobImage = 0;
+const int jobAudio = 1;
+
+struct LoadJob {
+    int type;
+    std::string filename;
+    SDL_Surface *surface;
+    Mix_Chunk *chunk;
+    std::string error;
+};
+
+// Decodes images and audio effects on worker threads. Only decoding happens
+// here; anything needing the renderer (i.e. texture creation) is left to the
+// caller, which collects the results with takeImage and takeAudio once
+// isDone returns true.
+class AssetLoader {
+public:
+    AssetLoader();
+    ~AssetLoader();
+
+    void addImage(const std::string &filename);
+    void addAudio(const std::string &filename);
+    void start();
+    bool isDone();
+    void wait();
+    int completed();
+    int total() const;
+
+    SDL_Surface* takeImage(const std::string &filename);
+    Mix_Chunk* takeAudio(const std::string &filename);
+    void logErrors() const;
+
+private:
+    static int workerMain(void *data);
+
+    std::vector<LoadJob> mJobs;
+    std::map<std::string, unsigned> mIndex;
+    std::vector<SDL_Thread*> mThreads;
+    SDL_atomic_t mNextJob;
+    SDL_atomic_t mCompleted;
+};
+
+SDL_Surface* decodeImage(const std::string &filename, std::string &error);
+Mix_Chunk* decodeAudio(const std::string &filename, std::string &error);
+
+#endif
@@ -27,13 +27,13 @@ void mapedloop(GameState &state) {
     state.getBoard()->calcFOV(state.getPlayer()->position);
 
     state.runDirection = Dir::None;
-    state.lastticks = SDL_GetTicks();
+    state.resetFrameTimer();
 
     while (!state.wantsToQuit && !state.returnToMenu) {
         repaint(state);
 
         SDL_Event event;
-        while (SDL_PollEvent(&event)) {
+        while (state.nextEvent(event)) {
             const CommandDef &cmd = getCommand(state, event, mapedCommands);
             switch(cmd.command) {
                 case Command::None:
@@ -140,8 +140,8 @@ void mapedloop(GameState &state) {
                     for (int y = topLeft.y(); y <= playerPos.y(); ++y) {
                         for (int x = topLeft.x(); x <= playerPos.x(); ++x) {
                             int tile = state.mapEditTile;
-                            if (tile == -1) tile = grassList[state.coreRNG.next32() % grassList.size()];
-                            else if (tile == -2) tile = treeList[state.coreRNG.next32() % treeList.size()];
+                            if (tile == -1) tile = grassList[state.miscRNG.below(grassList.size())];
+                            else if (tile == -2) tile = treeList[state.miscRNG.below(treeList.size())];
                             state.getBoard()->setTile(Point(x, y), tile);
                         }
                     }
@@ -0,0 +1,98 @@
+#include <utility>
+
+#include "messagelog.h"
+#include "textutil.h"
+
+MessageLog::MessageLog(unsigned capacity)
+: mFirst(0), mCount(0)
+{
+    setCapacity(capacity);
+}
+
+// Changing the capacity keeps the most recent messages that still fit.
+void MessageLog::setCapacity(unsigned capacity) {
+    if (capacity < 1) capacity = 1;
+    if (capacity == mMessages.size()) return;
+
+    std::vector<Message> newMessages(capacity);
+    unsigned keep = mCount < capacity ? mCount : capacity;
+    for (unsigned i = 0; i < keep; ++i) {
+        newMessages[i] = std::move(at(mCount - keep + i));
+    }
+    mMessages.swap(newMessages);
+    mFirst = 0;
+    mCount = keep;
+}
+
+unsigned MessageLog::capacity() const {
+    return mMessages.size();
+}
+
+unsigned MessageLog::size() const {
+    return mCount;
+}
+
+bool MessageLog::empty() const {
+    return mCount == 0;
+}
+
+void MessageLog::clear() {
+    for (Message &m : mMessages) {
+        m.text.clear();
+        m.lines.clear();
+        m.wrapWidth = -1;
+    }
+    mFirst = mCount = 0;
+}
+
+void MessageLog::add(int turnNumber, const std::string &text) {
+    if (mCount < mMessages.size()) {
+        ++mCount;
+    } else {
+        mFirst = (mFirst + 1) % mMessages.size();
+    }
+    Message &m = at(mCount - 1);
+    m.newTurns = turnNumber;
+    m.text = text;
+    m.wrapWidth = -1;
+}
+
+void MessageLog::appendToLast(const std::string &text) {
+    Message &m = at(mCount - 1);
+    m.text += text;
+    m.wrapWidth = -1;
+}
+
+void MessageLog::replaceLast(const std::string &text) {
+    Message &m = at(mCount - 1);
+    m.text = text;
+    m.wrapWidth = -1;
+}
+
+void MessageLog::removeLast() {
+    if (mCount > 0) --mCount;
+}
+
+const Message& MessageLog::operator[](unsigned index) const {
+    return mMessages[(mFirst + index) % mMessages.size()];
+}
+
+Message& MessageLog::at(unsigned index) {
+    return mMessages[(mFirst + index) % mMessages.size()];
+}
+
+// Get the text of a message word wrapped to width characters, wrapping it
+// only if it hasn't already been wrapped to that width.
+const std::vector<std::string>& MessageLog::wrapped(unsigned index, int width) {
+    Message &m = at(index);
+    if (m.wrapWidth != width) {
+        m.lines.clear();
+        std::string text = m.text;
+        wordwrap(text, width, m.lines);
+        for (unsigned i = 1; i < m.lines.size(); ++i) {
+            m.lines[i].insert(0, "  ");
+        }
+        m.wrapWidth = width;
+    }
+    return m.lines;
+}
@@ -0,0 +1,47 @@
+#ifndef MESSAGELOG_H
+#define MESSAGELOG_H
+
+#include <string>
+#include <vector>
+
+const unsigned defaultMessageHistory = 500;
+const unsigned maxMessageHistory = 100000;
+
+struct Message {
+    int newTurns;
+    std::string text;
+    // text broken into lines by MessageLog::wrapped; continuation lines are
+    // already indented. Only valid while wrapWidth matches the width asked for.
+    int wrapWidth;
+    std::vector<std::string> lines;
+};
+
+// The message log, kept as a ring buffer holding the most recent messages.
+// Index 0 is the oldest message still held. Slots are reused as old messages
+// are dropped, so once the log is full adding messages rarely allocates.
+class MessageLog {
+public:
+    MessageLog(unsigned capacity = defaultMessageHistory);
+
+    void setCapacity(unsigned capacity);
+    unsigned capacity() const;
+    unsigned size() const;
+    bool empty() const;
+    void clear();
+
+    void add(int turnNumber, const std::string &text);
+    void appendToLast(const std::string &text);
+    void replaceLast(const std::string &text);
+    void removeLast();
+
+    const Message& operator[](unsigned index) const;
+    const std::vector<std::string>& wrapped(unsigned index, int width);
+
+private:
+    Message& at(unsigned index);
+
+    std::vector<Message> mMessages;
+    unsigned mFirst, mCount;
+};
+
+#endif
@@ -1,5 +1,4 @@
 #include <iomanip>
-#include <sstream>
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
@@ -38,7 +37,7 @@ void gfx_drawCharInfo(GameState &state, bool callPresent) {
     const double healthPercent = static_cast<double>(player->curHealth) / static_cast<double>(player->typeInfo->maxHealth);
     const double energyPercent = static_cast<double>(player->curEnergy) / static_cast<double>(player->typeInfo->maxEnergy);
 
-    state.smallFont->out(xPos, yPos, player->name);
+    state.smallFont->out(xPos, yPos, player->details->name);
     yPos += lineHeight;
     gfx_DrawBar(state, xPos, yPos, barWidth, barHeight, healthPercent, Color{127,255,127});
     yPos += barHeight;
@@ -68,11 +67,7 @@ void gfx_drawCharInfo(GameState &state, bool callPresent) {
 
     //  ////  ////  ////  ////  ////  ////  ////  ////  ////  ////  ////  ////
     //  FPS INFO
-    if (state.showFPS) {
-        std::stringstream ss;
-        ss << "  FPS: " << state.getFPS();
-        state.smallFont->out(0, 0, ss.str().c_str());
-    }
+    if (state.showFPS) gfx_DrawFrameStats(state, 0, 0);
 
     state.advanceFrame();
     if (callPresent) SDL_RenderPresent(state.renderer);
@@ -85,7 +80,7 @@ void doCharInfo(GameState &system) {
         gfx_drawCharInfo(system, true);
 
         SDL_Event event;
-        while (SDL_PollEvent(&event)) {
+        while (system.nextEvent(event)) {
             if (event.type == SDL_MOUSEBUTTONDOWN) {
                 if (pointInBox(event.button.x, event.button.y, doneButton)) {
                     return;
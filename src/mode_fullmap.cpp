@@ -1,10 +1,10 @@
 #include <SDL2/SDL.h>
-#include <sstream>
 
 #include "actor.h"
 #include "board.h"
 #include "game.h"
 #include "gamestate.h"
+#include "gfx_minimap.h"
 #include "command.h"
 
 static SDL_Rect doneButton = { -1 };
@@ -26,47 +26,28 @@ void gfx_DrawMap(GameState &system) {
     SDL_SetRenderDrawColor(system.renderer, 0, 0, 0, SDL_ALPHA_OPAQUE);
     SDL_RenderClear(system.renderer);
 
-    for (int y = 0; y < board->height(); ++y) {
-        for (int x = 0; x < board->width(); ++x) {
-            const Point here(x, y);
-
-            if (!board->isKnown(here)) continue;
-            const bool visible = board->isVisible(here);
-
-            SDL_Rect texturePosition = {
-                offsetX + x * mapTileWidth,
-                offsetY + y * mapTileHeight,
-                mapTileWidth,      mapTileHeight
-            };
-
-            const TileInfo &tileInfo = TileInfo::get(board->getTile(here));
-            if (visible) {
-                SDL_SetRenderDrawColor(system.renderer, tileInfo.red, tileInfo.green, tileInfo.blue, SDL_ALPHA_OPAQUE);
-            } else {
-                SDL_SetRenderDrawColor(system.renderer, tileInfo.red / 3, tileInfo.green / 3, tileInfo.blue / 3, SDL_ALPHA_OPAQUE);
-            }
-            SDL_RenderFillRect(system.renderer, &texturePosition);
-
-            if (visible) {
-                Actor *actorHere = board->actorAt(here);
-                if (actorHere) {
-                    SDL_Rect objectPosition = {
-                        texturePosition.x + 1, texturePosition.y + 1,
-                        texturePosition.w - 2, texturePosition.h - 2
-                    };
-                    if (objectPosition.w < 1) {
-                        objectPosition = texturePosition;
-                    }
+    const SDL_Rect mapArea = {
+        offsetX, offsetY, mapTileWidth * board->width(), mapTileHeight * board->height()
+    };
+    system.minimap->draw(board, mapArea);
+
+    for (const Actor *actor : board->getActors()) {
+        if (!board->isVisible(actor->position)) continue;
+        SDL_Rect objectPosition = {
+            offsetX + actor->position.x() * mapTileWidth + 1,
+            offsetY + actor->position.y() * mapTileHeight + 1,
+            mapTileWidth - 2, mapTileHeight - 2
+        };
+        if (objectPosition.w < 1) {
+            objectPosition = SDL_Rect{ objectPosition.x - 1, objectPosition.y - 1, mapTileWidth, mapTileHeight };
+        }
 
-                    if (actorHere->typeInfo->aiType == aiPlayer) {
-                        SDL_SetRenderDrawColor(system.renderer, 32, 192, 32, SDL_ALPHA_OPAQUE);
-                    } else {
-                        SDL_SetRenderDrawColor(system.renderer, 192, 32, 192, SDL_ALPHA_OPAQUE);
-                    }
-                    SDL_RenderFillRect(system.renderer, &objectPosition);
-                }
-            }
+        if (actor->typeInfo->aiType == aiPlayer) {
+            SDL_SetRenderDrawColor(system.renderer, 32, 192, 32, SDL_ALPHA_OPAQUE);
+        } else {
+            SDL_SetRenderDrawColor(system.renderer, 192, 32, 192, SDL_ALPHA_OPAQUE);
         }
+        SDL_RenderFillRect(system.renderer, &objectPosition);
     }
 
     if (doneButton.x < 0) {
@@ -77,24 +58,23 @@ void gfx_DrawMap(GameState &system) {
     }
     gfx_DrawButton(system, doneButton, false, "Done");
 
-    if (system.showFPS) {
-        std::stringstream ss;
-        ss << "  FPS: " << system.getFPS();
-        system.smallFont->out(0, 0, ss.str().c_str());
-    }
+    if (system.showFPS) gfx_DrawFrameStats(system, 0, 0);
 
     system.advanceFrame();
     SDL_RenderPresent(system.renderer);
 }
 
 void doShowMap(GameState &system) {
+    // nothing on the board changes while the map is open
+    if (!system.minimap) system.minimap = new Minimap(system.renderer);
+    system.minimap->update(system.getBoard());
     while (1) {
         gfx_DrawMap(system);
 
         // ////////////////////////////////////////////////////////////////////
         // event loop
         SDL_Event event;
-        while (SDL_PollEvent(&event)) {
+        while (system.nextEvent(event)) {
             if (event.type == SDL_MOUSEBUTTONDOWN) {
                 if (pointInBox(event.button.x, event.button.y, doneButton)) {
                     return;
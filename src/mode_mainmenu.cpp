@@ -13,13 +13,15 @@
 #include "config.h"
 #include "actor.h"
 #include "random.h"
+#include "replay.h"
+#include "savegame.h"
 #include "textutil.h"
 
 std::vector<std::string> creditsText;
 static void loadCredits();
 
 static std::string getRandomName(Random &rng) {
-    switch(rng.next32() % 21) {
+    switch(rng.below(21)) {
         case  0: return "Eadweard";
         case  1: return "Gery";
         case  2: return "Cuthbaeld";
@@ -71,6 +73,8 @@ void doGameMenu(GameState &state) {
     state.playMusic(0);
 
     while (!state.wantsToQuit) {
+        mainMenu.getOptionByCode(menuLoadSaved).type = newestSave().empty() ? MenuType::Disabled : MenuType::Choice;
+        if (!state.gameInProgress) mainMenu.getOptionByCode(menuResumeGame).type = MenuType::Disabled;
         int choice = mainMenu.run(state);
         switch(choice) {
             case menuQuit:
@@ -82,18 +86,36 @@ void doGameMenu(GameState &state) {
                         break;
                     }
                 }
+                state.finishLoading();
                 state.gameInProgress = true;
                 mainMenu.getOptionByCode(menuResumeGame).type = MenuType::Choice;
                 state.reset();
+                if (state.recording) state.recording->begin(state.gameSeed, *state.config);
                 Actor *player = state.getPlayer();
-                player->name = getRandomName(state.coreRNG);
-                player->hasProperName = true;
-                gfx_EditText(state, "Name?", state.getPlayer()->name, 16);
+                player->details->name = getRandomName(state.miscRNG);
+                player->details->hasProperName = true;
+                gfx_EditText(state, "Name?", state.getPlayer()->details->name, 16);
                 state.vm->runFunction("start");
                 gameloop(state);
                 mainMenu.setSelectedByCode(menuResumeGame);
                 state.playMusic(0);
                 break; }
+            case menuLoadSaved: {
+                if (state.gameInProgress) {
+                    if (!gfx_Confirm(state, "Load saved game?", "This will abandon your current game!", true)) {
+                        break;
+                    }
+                }
+                state.finishLoading();
+                if (!loadGame(state, newestSave())) {
+                    gfx_Alert(state, "Failed to load saved game.", "See the log file for details.");
+                    break;
+                }
+                mainMenu.getOptionByCode(menuResumeGame).type = MenuType::Choice;
+                gameloop(state);
+                mainMenu.setSelectedByCode(menuResumeGame);
+                state.playMusic(0);
+                break; }
             case menuResumeGame:
             case menuClose:
                 if (state.gameInProgress) {
@@ -56,14 +56,15 @@ void doOptionsMenu(GameState &state) {
 
     const int initialMusicVolume = Mix_VolumeMusic(-1);
     const int initialAudioVolume = Mix_Volume(-1, -1);
-    const int initialFontScale   = state.config->getInt("font_scale", 1);
+    const Settings &settings = state.config->settings();
+    const int initialFontScale   = settings.fontScale;
     optionsMenu.getOptionByCode(menuMusic).value = initialMusicVolume;
     optionsMenu.getOptionByCode(menuAudio).value = initialAudioVolume;
-    optionsMenu.getOptionByCode(menuTile).value = state.config->getInt("tile_scale", 1);
+    optionsMenu.getOptionByCode(menuTile).value = settings.tileScale;
     optionsMenu.getOptionByCode(menuFont).value = initialFontScale;
-    optionsMenu.getOptionByCode(menuFullscreen).value = state.config->getBool("fullscreen", false);
-    optionsMenu.getOptionByCode(menuShowDiceRolls).value = state.config->getBool("showrolls", false);
-    optionsMenu.getOptionByCode(menuAnimDelay).value = state.config->getInt("anim_delay", 100);
+    optionsMenu.getOptionByCode(menuFullscreen).value = settings.fullscreen;
+    optionsMenu.getOptionByCode(menuShowDiceRolls).value = settings.showRolls;
+    optionsMenu.getOptionByCode(menuAnimDelay).value = settings.animDelay;
     optionsMenu.setSelectedByCode(menuMusic);
 
     state.playMusic(0);
@@ -97,5 +98,6 @@ void doOptionsMenu(GameState &state) {
         state.config->set("fullscreen", optionsMenu.getOptionByCode(menuFullscreen).value ? 1 : 0);
         state.config->set("showrolls",  optionsMenu.getOptionByCode(menuShowDiceRolls).value ? 1 : 0);
         state.config->set("anim_delay", optionsMenu.getOptionByCode(menuAnimDelay).value);
+        state.config->notifyChanged();
     }
 }
@@ -96,7 +96,7 @@ Dir rotateDirection45(Dir original) {
 }
 
 Dir randomDirection(Random &rng) {
-    switch(rng.next32() % 4) {
+    switch(rng.below(4)) {
         case 0: return Dir::North;
         case 1: return Dir::East;
         case 2: return Dir::South;
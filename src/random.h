@@ -3,11 +3,16 @@
 
     Based on XorShift+ as described at:
     https://codingha.us/2018/12/17/xorshift-fast-csharp-random-number-generator/
+
+    Seeds (and the states of split off streams) are expanded with SplitMix64,
+    and bounded values use Lemire's multiply-and-reject method so that every
+    value in the range is equally likely.
 */
 
 #ifndef RANDOM_H
 #define RANDOM_H
 
+#include <cstddef>
 #include <cstdint>
 
 class Random {
@@ -17,8 +22,29 @@ public:
     { }
 
     void seed(std::uint64_t seed) {
-        v1 = seed << 1;
-        v2 = seed >> 2;
+        v1 = splitMix(seed);
+        v2 = splitMix(seed);
+        if (v1 == 0 && v2 == 0) v2 = 1;
+    }
+
+    // A new generator for a separate stream of values, such as for one
+    // subsystem. The same generator state and stream id always give the same
+    // stream, and taking a stream doesn't advance this generator.
+    Random split(std::uint64_t streamId) const {
+        Random result;
+        result.seed(v1 ^ splitMix64(v2 + streamId));
+        return result;
+    }
+
+    // the whole state of the generator, for saved games
+    void getState(std::uint64_t state[2]) const {
+        state[0] = v1;
+        state[1] = v2;
+    }
+    void setState(const std::uint64_t state[2]) {
+        v1 = state[0];
+        v2 = state[1];
+        if (v1 == 0 && v2 == 0) v2 = 1;
     }
 
     uint64_t next64() {
@@ -32,17 +58,32 @@ public:
         return result;
     }
 
+    // the high bits of XorShift+ output are the stronger ones
     uint32_t next32() {
-        int result;
-        uint64_t t1, t2;
+        return static_cast<uint32_t>(next64() >> 32);
+    }
 
-        t1 = v2;
-        v1 ^= v1 << 23;
-        t2 = v1 ^ v2 ^ (v1 >> 17) ^ (v2 >> 26);
-        result = static_cast<int>(t2 + v2);
-        v1 = t1;
-        v2 = t2;
-        return result;
+    // a value from 0 to bound - 1
+    uint32_t below(uint32_t bound) {
+        if (bound <= 1) return 0;
+        uint64_t m = static_cast<uint64_t>(next32()) * bound;
+        uint32_t low = static_cast<uint32_t>(m);
+        if (low < bound) {
+            const uint32_t threshold = -bound % bound;
+            while (low < threshold) {
+                m = static_cast<uint64_t>(next32()) * bound;
+                low = static_cast<uint32_t>(m);
+            }
+        }
+        return static_cast<uint32_t>(m >> 32);
+    }
+
+    // fill a buffer with values, or with values from 0 to bound - 1
+    void fill(uint32_t *values, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) values[i] = next32();
+    }
+    void fillBelow(uint32_t *values, std::size_t count, uint32_t bound) {
+        for (std::size_t i = 0; i < count; ++i) values[i] = below(bound);
     }
 
     unsigned roll(unsigned dice, unsigned sides) {
@@ -54,13 +95,22 @@ public:
     }
 
     unsigned between(unsigned low, unsigned high) {
-        unsigned range = high - low + 1;
-        unsigned value = next32();
-        return low + (value % range);
+        return low + below(high - low + 1);
     }
 
 private:
+    static uint64_t splitMix64(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ULL;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+    static uint64_t splitMix(uint64_t &state) {
+        state += 0x9E3779B97F4A7C15ULL;
+        return splitMix64(state - 0x9E3779B97F4A7C15ULL);
+    }
+
     std::uint64_t v1, v2;
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+#include "board.h"
+#include "config.h"
+#include "game.h"
+#include "gamestate.h"
+#include "logger.h"
+#include "replay.h"
+#include "savegame.h"
+#include "vm.h"
+
+// the only settings that change what happens in a game rather than how it
+// is shown
+static const char *replaySettings[] = {
+    "persistent_boards", "catchup_turns", "symmetric_fov", nullptr
+};
+
+const char replayMagic[4] = { 'L', 'L', 'R', 'C' };
+const unsigned replayVersion = 3;
+
+Recording::Recording(const std::string &filename)
+: mFilename(filename), mSeed(0)
+{ }
+
+// The settings are recorded with the values actually in effect, defaults
+// included, so that a replay doesn't depend on the configuration it's run with.
+void Recording::begin(std::uint64_t seed, const Config &config) {
+    const Settings &settings = config.settings();
+    mSeed = seed;
+    mSettings.clear();
+    mActions.clear();
+    mSettings.push_back(std::make_pair("persistent_boards", settings.persistentBoards ? "1" : "0"));
+    mSettings.push_back(std::make_pair("catchup_turns", std::to_string(settings.catchUpTurns)));
+    mSettings.push_back(std::make_pair("symmetric_fov", settings.symmetricFOV ? "1" : "0"));
+}
+
+void Recording::add(const PlayerAction &action) {
+    mActions.push_back(action);
+}
+
+// Each action takes six bytes: the command, the direction, and the two
+// arguments as signed 16 bit values.
+bool Recording::save() const {
+    Logger &log = Logger::getInstance();
+    SaveWriter out;
+    out.writeBytes(replayMagic, sizeof(replayMagic));
+    out.writeShort(replayVersion);
+    out.writeLong(mSeed);
+    out.writeShort(mSettings.size());
+    for (const auto &setting : mSettings) {
+        out.writeString(setting.first);
+        out.writeString(setting.second);
+    }
+    out.writeWord(mActions.size());
+    for (const PlayerAction &action : mActions) {
+        out.writeByte(static_cast<unsigned>(action.command));
+        out.writeByte(static_cast<unsigned>(action.direction));
+        out.writeShort(static_cast<std::uint16_t>(action.arg1));
+        out.writeShort(static_cast<std::uint16_t>(action.arg2));
+    }
+
+    std::ofstream file(mFilename, std::ios::binary);
+    if (!file) {
+        log.error("Failed to open recording " + mFilename + " for writing.");
+        return false;
+    }
+    file.write(out.data(), out.size());
+    if (!file) {
+        log.error("Failed to write recording " + mFilename + ".");
+        return false;
+    }
+    log.info("Wrote " + std::to_string(mActions.size()) + " actions to " + mFilename + ".");
+    return true;
+}
+
+bool Recording::load() {
+    Logger &log = Logger::getInstance();
+    std::ifstream file(mFilename, std::ios::binary);
+    if (!file) {
+        log.error("Failed to open recording " + mFilename + ".");
+        return false;
+    }
+    std::vector<char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (buffer.size() < sizeof(replayMagic)
+            || !std::equal(replayMagic, replayMagic + sizeof(replayMagic), buffer.begin())) {
+        log.error(mFilename + " is not a recording.");
+        return false;
+    }
+
+    mSettings.clear();
+    mActions.clear();
+    try {
+        SaveReader in(buffer.data(), buffer.size());
+        in.readBytes(sizeof(replayMagic));
+        const unsigned version = in.readShort();
+        if (version != replayVersion) {
+            log.error(mFilename + " has unsupported recording version " + std::to_string(version) + ".");
+            return false;
+        }
+        mSeed = in.readLong();
+        const unsigned settingCount = in.readShort();
+        for (unsigned i = 0; i < settingCount; ++i) {
+            std::string key = in.readString();
+            std::string value = in.readString();
+            mSettings.push_back(std::make_pair(key, value));
+        }
+        const unsigned actionCount = in.readWord();
+        for (unsigned i = 0; i < actionCount; ++i) {
+            PlayerAction action;
+            action.command = static_cast<Command>(in.readByte());
+            action.direction = static_cast<Dir>(in.readByte());
+            action.arg1 = static_cast<std::int16_t>(in.readShort());
+            action.arg2 = static_cast<std::int16_t>(in.readShort());
+            mActions.push_back(action);
+        }
+    } catch (GameError &e) {
+        log.error("Recording " + mFilename + " is truncated.");
+        return false;
+    }
+
+    for (int i = 0; replaySettings[i]; ++i) {
+        auto iter = std::find_if(mSettings.begin(), mSettings.end(),
+                [i](const std::pair<std::string, std::string> &setting) {
+                    return setting.first == replaySettings[i];
+                });
+        if (iter == mSettings.end()) {
+            log.error("Recording " + mFilename + " doesn't include the " + replaySettings[i] + " setting.");
+            return false;
+        }
+    }
+    return true;
+}
+
+// Bring the game to the point where the next action is taken: any animations
+// land and any turn the last action used up is played.
+static void settleTurn(GameState &state) {
+    if (!state.animations.empty()) state.animations.finish(state);
+    if (state.hasTick()) state.tick();
+}
+
+static double toMilliseconds(unsigned long long ticks, double frequency) {
+    return ticks * 1000.0 / frequency;
+}
+
+// Play a recording back as fast as possible without drawing anything and
+// write the timings and where the game ended up to stdout as a single JSON
+// object.
+int runReplay(GameState &state, const Recording &recording) {
+    Logger &log = Logger::getInstance();
+    state.replaying = true;
+    for (const auto &setting : recording.getSettings()) {
+        state.config->set(setting.first, setting.second);
+    }
+    state.config->notifyChanged();
+    try {
+        state.finishLoading();
+        state.reset(recording.getSeed());
+        state.gameInProgress = true;
+        state.vm->runFunction("start");
+    } catch (GameError &e) {
+        log.error(std::string("Replay failed to start game: ") + e.what());
+        return 1;
+    }
+    if (!state.getBoard() || !state.getPlayer()) {
+        log.error("Replay failed to start game: no starting map.");
+        return 1;
+    }
+    state.getBoard()->calcFOV(state.getPlayer()->position);
+
+    turnProfile = TurnProfile{0, 0, 0, 0};
+    const int firstTurn = state.turnNumber;
+    const Uint64 start = SDL_GetPerformanceCounter();
+    unsigned actionCount = 0;
+    for (const PlayerAction &recorded : recording.getActions()) {
+        if (state.wantsToQuit) break;
+        settleTurn(state);
+        PlayerAction action = recorded;
+        performAction(state, action);
+        ++actionCount;
+    }
+    settleTurn(state);
+    if (!state.animations.empty()) state.animations.finish(state);
+    const Uint64 end = SDL_GetPerformanceCounter();
+
+    const double frequency = SDL_GetPerformanceFrequency();
+    const double seconds = (end - start) / frequency;
+    const int turns = state.turnNumber - firstTurn;
+    const Actor *player = state.getPlayer();
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "{\"seed\":" << recording.getSeed() << ",\"actions\":" << actionCount;
+    std::cout << ",\"turns\":" << turns << ",\"seconds\":" << seconds;
+    std::cout << ",\"turns_per_second\":" << (seconds > 0 ? turns / seconds : 0.0);
+    std::cout << ",\"ms\":{\"turns\":" << toMilliseconds(turnProfile.turn, frequency);
+    std::cout << ",\"fov\":" << toMilliseconds(turnProfile.fov, frequency);
+    std::cout << ",\"ai_plan\":" << toMilliseconds(turnProfile.plan, frequency);
+    std::cout << ",\"ai_resolve\":" << toMilliseconds(turnProfile.resolve, frequency);
+    std::cout << ",\"player\":" << toMilliseconds(end - start - turnProfile.turn, frequency) << "}";
+    std::cout << ",\"final\":{\"map\":" << state.getBoard()->getInfo().index;
+    std::cout << ",\"x\":" << player->position.x() << ",\"y\":" << player->position.y();
+    std::cout << ",\"health\":" << player->curHealth << ",\"energy\":" << player->curEnergy << "}}\n";
+    return 0;
+}
@@ -0,0 +1,59 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "command.h"
+#include "point.h"
+
+class Config;
+class GameState;
+
+// A command that changes the game, with any prompts it needed already
+// answered. For runs and rests, arg1 is the number of turns it lasted; for
+// debug warps, arg1 is the map and for teleports arg1 and arg2 are the
+// destination.
+struct PlayerAction {
+    Command command;
+    Dir direction;
+    int arg1, arg2;
+};
+
+// Everything needed to play a game back: the seed it was started with, the
+// settings that affect play, and the actions taken.
+class Recording {
+public:
+    Recording(const std::string &filename = "");
+
+    void begin(std::uint64_t seed, const Config &config);
+    void add(const PlayerAction &action);
+    bool save() const;
+    bool load();
+
+    const std::string& getFilename() const {
+        return mFilename;
+    }
+    std::uint64_t getSeed() const {
+        return mSeed;
+    }
+    const std::vector<std::pair<std::string, std::string> >& getSettings() const {
+        return mSettings;
+    }
+    const std::vector<PlayerAction>& getActions() const {
+        return mActions;
+    }
+
+private:
+    std::string mFilename;
+    std::uint64_t mSeed;
+    std::vector<std::pair<std::string, std::string> > mSettings;
+    std::vector<PlayerAction> mActions;
+};
+
+void performAction(GameState &state, PlayerAction &action);
+int runReplay(GameState &state, const Recording &recording);
+
+#endif
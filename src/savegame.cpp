@@ -0,0 +1,352 @@
+#include <cstring>
+#include <initializer_list>
+#include <physfs.h>
+#include <SDL2/SDL.h>
+
+#include "board.h"
+#include "config.h"
+#include "game.h"
+#include "gamestate.h"
+#include "logger.h"
+#include "replay.h"
+#include "savegame.h"
+#include "vm.h"
+
+const char saveMagic[4] = { 'L', 'L', 'S', 'V' };
+const unsigned saveVersion = 3;
+// magic number, version, checksum of the game data it was saved with, and
+// checksum of everything after them
+const unsigned saveHeaderSize = 14;
+const unsigned saveChecksumPosition = 10;
+
+void SaveWriter::writeByte(unsigned value) {
+    mData.push_back(static_cast<char>(value & 0xFF));
+}
+
+void SaveWriter::writeShort(unsigned value) {
+    writeByte(value);
+    writeByte(value >> 8);
+}
+
+void SaveWriter::writeWord(std::uint32_t value) {
+    writeShort(value);
+    writeShort(value >> 16);
+}
+
+void SaveWriter::writeLong(std::uint64_t value) {
+    writeWord(static_cast<std::uint32_t>(value));
+    writeWord(static_cast<std::uint32_t>(value >> 32));
+}
+
+void SaveWriter::writeInt(int value) {
+    writeWord(static_cast<std::uint32_t>(value));
+}
+
+void SaveWriter::writeString(const std::string &text) {
+    writeShort(text.size());
+    writeBytes(text.data(), text.size());
+}
+
+void SaveWriter::writeBytes(const void *data, unsigned length) {
+    const char *bytes = static_cast<const char*>(data);
+    mData.insert(mData.end(), bytes, bytes + length);
+}
+
+void SaveWriter::patchWord(unsigned position, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        mData[position + i] = static_cast<char>((value >> (i * 8)) & 0xFF);
+    }
+}
+
+SaveReader::SaveReader(const char *data, unsigned size)
+: mData(data), mSize(size), mPosition(0)
+{ }
+
+unsigned SaveReader::readByte() {
+    return static_cast<unsigned char>(*readBytes(1));
+}
+
+unsigned SaveReader::readShort() {
+    unsigned low = readByte();
+    return low | (readByte() << 8);
+}
+
+std::uint32_t SaveReader::readWord() {
+    std::uint32_t low = readShort();
+    return low | (static_cast<std::uint32_t>(readShort()) << 16);
+}
+
+std::uint64_t SaveReader::readLong() {
+    std::uint64_t low = readWord();
+    return low | (static_cast<std::uint64_t>(readWord()) << 32);
+}
+
+int SaveReader::readInt() {
+    return static_cast<std::int32_t>(readWord());
+}
+
+std::string SaveReader::readString() {
+    unsigned length = readShort();
+    return std::string(readBytes(length), length);
+}
+
+const char* SaveReader::readBytes(unsigned length) {
+    if (length > mSize - mPosition) throw GameError("Saved game is truncated.");
+    const char *result = mData + mPosition;
+    mPosition += length;
+    return result;
+}
+
+// FNV-1a
+static std::uint32_t checksum(const char *data, unsigned length) {
+    std::uint32_t hash = 2166136261u;
+    for (unsigned i = 0; i < length; ++i) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static void writeRandom(SaveWriter &out, const Random &rng) {
+    std::uint64_t rngState[2];
+    rng.getState(rngState);
+    out.writeLong(rngState[0]);
+    out.writeLong(rngState[1]);
+}
+
+static void readRandom(SaveReader &in, Random &rng) {
+    std::uint64_t rngState[2];
+    rngState[0] = in.readLong();
+    rngState[1] = in.readLong();
+    rng.setState(rngState);
+}
+
+// VM memory is written as the runs of bytes that differ from the image as it
+// was loaded, ending with an empty run.
+static void writeMemory(SaveWriter &out, const VM &vm) {
+    const char *memory = vm.getMemory();
+    const char *image = vm.getImage();
+    const unsigned size = vm.getMemorySize();
+    out.writeWord(size);
+    unsigned position = 0;
+    while (position < size) {
+        if (memory[position] == image[position]) {
+            ++position;
+            continue;
+        }
+        unsigned end = position + 1;
+        while (end < size && memory[end] != image[end]) ++end;
+        out.writeWord(position);
+        out.writeWord(end - position);
+        out.writeBytes(memory + position, end - position);
+        position = end;
+    }
+    out.writeWord(0);
+    out.writeWord(0);
+}
+
+static void readMemory(SaveReader &in, VM &vm) {
+    if (in.readWord() != vm.getMemorySize()) throw GameError("Saved game is for a different version of the game data.");
+    vm.restoreImage();
+    while (1) {
+        const unsigned address = in.readWord();
+        const unsigned length = in.readWord();
+        if (length == 0) break;
+        vm.writeMemory(address, in.readBytes(length), length);
+    }
+}
+
+// The maps themselves aren't saved; loading rebuilds them from the seed and
+// each board only saves how it differs from that.
+bool saveGame(GameState &state, const std::string &filename) {
+    Logger &log = Logger::getInstance();
+    if (!state.gameInProgress || !state.getBoard() || !state.getPlayer()) {
+        log.warn("Tried to save with no game in progress.");
+        return false;
+    }
+    const Uint64 start = SDL_GetPerformanceCounter();
+
+    SaveWriter out;
+    out.writeBytes(saveMagic, sizeof(saveMagic));
+    out.writeShort(saveVersion);
+    out.writeWord(checksum(state.vm->getImage(), state.vm->getMemorySize()));
+    out.writeWord(0);
+    out.writeLong(state.gameSeed);
+
+    out.writeInt(state.turnNumber);
+    out.writeInt(state.depth);
+    out.writeInt(state.swordLevel);
+    out.writeInt(state.armourLevel);
+    for (int i = 0; i < SW_COUNT; ++i) out.writeInt(state.subweaponLevel[i]);
+    out.writeInt(state.arrowCount);
+    out.writeInt(state.bombCount);
+    out.writeInt(state.coinCount);
+    out.writeInt(state.arrowCapacity);
+    out.writeInt(state.bombCapacity);
+    out.writeInt(state.currentSubweapon);
+    writeRandom(out, state.mapRNG);
+    writeRandom(out, state.aiRNG);
+    writeRandom(out, state.lootRNG);
+    writeRandom(out, state.combatRNG);
+
+    out.writeWord(state.itemLocations.size());
+    unsigned bits = 0;
+    for (unsigned i = 0; i < state.itemLocations.size(); ++i) {
+        if (state.itemLocations[i].used) bits |= 1 << (i % 8);
+        if (i % 8 == 7 || i + 1 == state.itemLocations.size()) {
+            out.writeByte(bits);
+            bits = 0;
+        }
+    }
+    writeMemory(out, *state.vm);
+
+    out.writeInt(state.getBoard()->getInfo().index);
+    out.writeWord(state.mBoards.size());
+    for (const auto &boardIter : state.mBoards) {
+        out.writeInt(boardIter.first);
+        boardIter.second->save(out, state);
+    }
+    out.patchWord(saveChecksumPosition, checksum(out.data() + saveHeaderSize, out.size() - saveHeaderSize));
+
+    PHYSFS_file *file = PHYSFS_openWrite(filename.c_str());
+    if (!file) {
+        log.error("Failed to open " + filename + " for writing.");
+        return false;
+    }
+    const PHYSFS_sint64 written = PHYSFS_writeBytes(file, out.data(), out.size());
+    PHYSFS_close(file);
+    if (written != static_cast<PHYSFS_sint64>(out.size())) {
+        log.error("Failed to write saved game " + filename + ".");
+        return false;
+    }
+    const double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    log.info("Saved game to " + filename + " (" + std::to_string(out.size()) + " bytes, " + std::to_string(ms) + " ms).");
+    return true;
+}
+
+// The file is read and checked before anything is changed, so a missing or
+// damaged save, or one made with different game data, leaves the current game
+// alone. If it still fails after that the game in progress is lost.
+bool loadGame(GameState &state, const std::string &filename) {
+    Logger &log = Logger::getInstance();
+    const Uint64 start = SDL_GetPerformanceCounter();
+    const std::string path = "/save/" + filename;
+    PHYSFS_file *file = PHYSFS_openRead(path.c_str());
+    if (!file) {
+        log.error("Failed to open saved game " + filename + ".");
+        return false;
+    }
+    std::vector<char> buffer(PHYSFS_fileLength(file));
+    const PHYSFS_sint64 read = PHYSFS_readBytes(file, buffer.data(), buffer.size());
+    PHYSFS_close(file);
+    if (read != static_cast<PHYSFS_sint64>(buffer.size()) || buffer.size() < saveHeaderSize
+            || memcmp(buffer.data(), saveMagic, sizeof(saveMagic)) != 0) {
+        log.error(filename + " is not a saved game.");
+        return false;
+    }
+
+    SaveReader in(buffer.data(), buffer.size());
+    in.readBytes(sizeof(saveMagic));
+    const unsigned version = in.readShort();
+    if (version != saveVersion) {
+        log.error(filename + " has unsupported save version " + std::to_string(version) + ".");
+        return false;
+    }
+    if (in.readWord() != checksum(state.vm->getImage(), state.vm->getMemorySize())) {
+        log.error("Saved game " + filename + " was made with different game data and can't be loaded.");
+        return false;
+    }
+    if (in.readWord() != checksum(buffer.data() + saveHeaderSize, buffer.size() - saveHeaderSize)) {
+        log.error("Saved game " + filename + " is damaged.");
+        return false;
+    }
+    if (state.recording) {
+        log.warn("Loading a saved game ends the current recording.");
+        state.recording->save();
+        state.recording = nullptr;
+    }
+
+    try {
+        state.reset(in.readLong());
+        state.turnNumber = in.readInt();
+        state.depth = in.readInt();
+        state.swordLevel = in.readInt();
+        state.armourLevel = in.readInt();
+        for (int i = 0; i < SW_COUNT; ++i) state.subweaponLevel[i] = in.readInt();
+        state.arrowCount = in.readInt();
+        state.bombCount = in.readInt();
+        state.coinCount = in.readInt();
+        state.arrowCapacity = in.readInt();
+        state.bombCapacity = in.readInt();
+        state.currentSubweapon = in.readInt();
+        readRandom(in, state.mapRNG);
+        readRandom(in, state.aiRNG);
+        readRandom(in, state.lootRNG);
+        readRandom(in, state.combatRNG);
+
+        const unsigned locationCount = in.readWord();
+        if (locationCount != state.itemLocations.size()) {
+            throw GameError("Saved game is for a different version of the game data.");
+        }
+        const char *locationBits = in.readBytes((locationCount + 7) / 8);
+        for (unsigned i = 0; i < locationCount; ++i) {
+            state.itemLocations[i].used = (locationBits[i / 8] >> (i % 8)) & 1;
+        }
+        readMemory(in, *state.vm);
+
+        const int currentIndex = in.readInt();
+        const unsigned boardCount = in.readWord();
+        for (unsigned i = 0; i < boardCount; ++i) {
+            auto boardIter = state.mBoards.find(in.readInt());
+            if (boardIter == state.mBoards.end()) {
+                throw GameError("Saved game is for a different version of the game data.");
+            }
+            boardIter->second->load(in, state);
+        }
+        auto current = state.mBoards.find(currentIndex);
+        if (current == state.mBoards.end() || current->second->getPlayer() != state.getPlayer()) {
+            throw GameError("Saved game has no current map.");
+        }
+        state.mCurrentBoard = current->second;
+    } catch (GameError &e) {
+        log.error("Failed to load " + filename + ": " + e.what());
+        state.endGame();
+        state.gameInProgress = false;
+        return false;
+    } catch (VMError &e) {
+        log.error("Failed to load " + filename + ": " + e.what());
+        state.endGame();
+        state.gameInProgress = false;
+        return false;
+    }
+
+    state.gameInProgress = true;
+    state.runDirection = Dir::None;
+    Board *board = state.getBoard();
+    board->calcFOV(state.getPlayer()->position);
+    if (board->getInfo().musicTrack >= 0) state.playMusic(board->getInfo().musicTrack);
+    const double ms = (SDL_GetPerformanceCounter() - start) * 1000.0 / SDL_GetPerformanceFrequency();
+    log.info("Loaded game from " + filename + " (" + std::to_string(ms) + " ms).");
+    return true;
+}
+
+bool saveExists(const std::string &filename) {
+    return PHYSFS_exists(("/save/" + filename).c_str());
+}
+
+// the most recently written of the quicksave and autosave, or an empty
+// string if there are neither
+std::string newestSave() {
+    std::string newest;
+    PHYSFS_sint64 newestTime = 0;
+    for (const char *filename : { quicksaveFile, autosaveFile }) {
+        PHYSFS_Stat stat;
+        const std::string path = std::string("/save/") + filename;
+        if (!PHYSFS_stat(path.c_str(), &stat)) continue;
+        if (newest.empty() || stat.modtime > newestTime) {
+            newest = filename;
+            newestTime = stat.modtime;
+        }
+    }
+    return newest;
+}
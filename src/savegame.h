@@ -0,0 +1,58 @@
+#ifndef SAVEGAME_H
+#define SAVEGAME_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class GameState;
+
+const char quicksaveFile[] = "quicksave.sav";
+const char autosaveFile[] = "autosave.sav";
+
+// Builds a saved game in memory so that it can be written out in one go. All
+// values are little endian.
+class SaveWriter {
+public:
+    void writeByte(unsigned value);
+    void writeShort(unsigned value);
+    void writeWord(std::uint32_t value);
+    void writeLong(std::uint64_t value);
+    void writeInt(int value);
+    void writeString(const std::string &text);
+    void writeBytes(const void *data, unsigned length);
+    void patchWord(unsigned position, std::uint32_t value);
+
+    unsigned size() const {
+        return mData.size();
+    }
+    const char* data() const {
+        return mData.data();
+    }
+private:
+    std::vector<char> mData;
+};
+
+// Reads back what SaveWriter wrote; reading past the end throws a GameError.
+class SaveReader {
+public:
+    SaveReader(const char *data, unsigned size);
+
+    unsigned readByte();
+    unsigned readShort();
+    std::uint32_t readWord();
+    std::uint64_t readLong();
+    int readInt();
+    std::string readString();
+    const char* readBytes(unsigned length);
+private:
+    const char *mData;
+    unsigned mSize, mPosition;
+};
+
+bool saveGame(GameState &state, const std::string &filename);
+bool loadGame(GameState &state, const std::string &filename);
+bool saveExists(const std::string &filename);
+std::string newestSave();
+
+#endif
@@ -1,3 +1,4 @@
+#include <cstring>
 #include <limits>
 #include <iomanip>
 #include <sstream>
@@ -59,11 +60,12 @@ std::ostream& operator<<(std::ostream &out, Opcode code) {
 
 
 VM::VM()
-: state(nullptr), mMemory(nullptr), mMemorySize(0), mCurrentPosition(0),
+: state(nullptr), mMemory(nullptr), mImage(nullptr), mMemorySize(0), mCurrentPosition(0),
   mImageFile("<memory>"), mIsValid(false)
 { }
 VM::~VM() {
     if (mMemory) delete[] mMemory;
+    if (mImage) delete[] mImage;
 }
 
 void VM::setGameState(GameState *newState) {
@@ -83,6 +85,10 @@ bool VM::loadFromFile(const std::string &filename, bool requireValid) {
 
     mMemorySize = length;
     mImageFile = filename;
+    // kept so that saved games only need what has changed since
+    if (mImage) delete[] mImage;
+    mImage = new char[length];
+    memcpy(mImage, mMemory, length);
 
     if (readWord(0) != FILE_ID_NUMBER) {
         mIsValid = false;
@@ -176,6 +182,29 @@ void VM::storeString(unsigned address, const std::string &text, unsigned maxLeng
     }
 }
 
+unsigned long long VM::getMemorySize() const {
+    return mMemorySize;
+}
+
+const char* VM::getMemory() const {
+    return mMemory;
+}
+
+// the memory as it was when the image was loaded
+const char* VM::getImage() const {
+    return mImage;
+}
+
+void VM::restoreImage() {
+    if (mMemory && mImage) memcpy(mMemory, mImage, mMemorySize);
+}
+
+void VM::writeMemory(unsigned address, const char *data, unsigned length) {
+    if (address + static_cast<unsigned long long>(length) > mMemorySize) {
+        throw VMError(mImageFile + ": Tried to write to address " + std::to_string(address) + " which is beyond EOF.");
+    }
+    memcpy(mMemory + address, data, length);
+}
 
 unsigned VM::getPosition() const {
     return mCurrentPosition;
@@ -491,7 +520,7 @@ bool VM::run(unsigned address) {
                 if (board) {
                     for (int x = x1; x <= x2; ++x) {
                         for (int y = y1; y <= y2; ++y) {
-                            int tile = tiles[state->coreRNG.next32() % tiles.size()];
+                            int tile = tiles[state->mapRNG.below(tiles.size())];
                             board->setTile(Point(x, y), tile);
                         }
                     }
@@ -594,7 +623,7 @@ bool VM::run(unsigned address) {
                 break; }
             case Opcode::mf_makemaze: {
                 unsigned flags = pop();
-                makeMapMaze(state->getBoard(), state->coreRNG, flags);
+                makeMapMaze(state->getBoard(), state->mapRNG, flags);
                 break; }
             case Opcode::mf_makefoes: {
                 unsigned infoAddr = pop();
@@ -608,7 +637,7 @@ bool VM::run(unsigned address) {
                     type = readWord(infoAddr);
                 }
 
-                mapRandomEnemies(state->getBoard(), state->coreRNG, info);
+                mapRandomEnemies(state->getBoard(), state->mapRNG, info);
                 break; }
 
             case Opcode::p_stat: {
@@ -697,11 +726,10 @@ void VM::addActor(int npcAddr) {
     int typeId     = readShort(npcAddr + 20);
 
     std::string name = nameAddr ? readString(nameAddr) : "";
-    Actor *actor = new Actor(typeId);
-    state->getBoard()->addActor(actor, Point(x, y));
-    actor->name = name;
-    actor->talkFunc = talkFunc;
-    actor->talkArg = special;
-    if (flags & 0x01) actor->hasProperName = true;
+    Actor *actor = state->getBoard()->createActor(typeId, Point(x, y));
+    actor->details->name = name;
+    actor->details->talkFunc = talkFunc;
+    actor->details->talkArg = special;
+    if (flags & 0x01) actor->details->hasProperName = true;
     actor->reset();
 }
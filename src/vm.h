@@ -43,6 +43,12 @@ public:
     void storeByte(unsigned address, unsigned value);
     void storeString(unsigned address, const std::string &text, unsigned maxLength);
 
+    unsigned long long getMemorySize() const;
+    const char* getMemory() const;
+    const char* getImage() const;
+    void restoreImage();
+    void writeMemory(unsigned address, const char *data, unsigned length);
+
     unsigned getPosition() const;
     void setPosition(unsigned address);
     int rewind(bool skipHeader);
@@ -77,6 +83,7 @@ private:
 
     GameState *state;
     char *mMemory;
+    char *mImage;
     unsigned long long mMemorySize;
     std::vector<Frame> mCallStack;
     unsigned mCurrentPosition;
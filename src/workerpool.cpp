@@ -0,0 +1,99 @@
+#include "logger.h"
+#include "workerpool.h"
+
+WorkerPool::WorkerPool(int threadCount)
+: mJob(nullptr), mJobCount(0), mBatch(0), mBusy(0), mQuit(false)
+{
+    SDL_AtomicSet(&mNextJob, 0);
+    mLock = SDL_CreateMutex();
+    mWake = SDL_CreateCond();
+    mDone = SDL_CreateCond();
+    if (!mLock || !mWake || !mDone) {
+        Logger::getInstance().warn(std::string("Failed to create worker pool: ") + SDL_GetError());
+        return;
+    }
+
+    if (threadCount > maxWorkerThreads) threadCount = maxWorkerThreads;
+    for (int i = 0; i < threadCount; ++i) {
+        SDL_Thread *thread = SDL_CreateThread(workerMain, "Worker", this);
+        if (thread) mThreads.push_back(thread);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    if (mLock) {
+        SDL_LockMutex(mLock);
+        mQuit = true;
+        SDL_CondBroadcast(mWake);
+        SDL_UnlockMutex(mLock);
+    }
+    for (SDL_Thread *thread : mThreads) {
+        SDL_WaitThread(thread, nullptr);
+    }
+    if (mDone) SDL_DestroyCond(mDone);
+    if (mWake) SDL_DestroyCond(mWake);
+    if (mLock) SDL_DestroyMutex(mLock);
+}
+
+int WorkerPool::threadCount() const {
+    return mThreads.size();
+}
+
+void WorkerPool::run(int count, const WorkerJob &job) {
+    if (count <= 0) return;
+    if (mThreads.empty() || count == 1) {
+        for (int i = 0; i < count; ++i) job(i);
+        return;
+    }
+
+    SDL_LockMutex(mLock);
+    mJob = &job;
+    mJobCount = count;
+    SDL_AtomicSet(&mNextJob, 0);
+    mBusy = mThreads.size();
+    ++mBatch;
+    SDL_CondBroadcast(mWake);
+    SDL_UnlockMutex(mLock);
+
+    work();
+
+    SDL_LockMutex(mLock);
+    while (mBusy > 0) SDL_CondWait(mDone, mLock);
+    mJob = nullptr;
+    SDL_UnlockMutex(mLock);
+}
+
+// As with the asset loader, jobs are handed out one at a time from a shared
+// counter.
+void WorkerPool::work() {
+    while (1) {
+        int index = SDL_AtomicAdd(&mNextJob, 1);
+        if (index >= mJobCount) break;
+        (*mJob)(index);
+    }
+}
+
+int WorkerPool::workerMain(void *data) {
+    WorkerPool *pool = static_cast<WorkerPool*>(data);
+    unsigned lastBatch = 0;
+    while (1) {
+        SDL_LockMutex(pool->mLock);
+        while (!pool->mQuit && pool->mBatch == lastBatch) {
+            SDL_CondWait(pool->mWake, pool->mLock);
+        }
+        if (pool->mQuit) {
+            SDL_UnlockMutex(pool->mLock);
+            break;
+        }
+        lastBatch = pool->mBatch;
+        SDL_UnlockMutex(pool->mLock);
+
+        pool->work();
+
+        SDL_LockMutex(pool->mLock);
+        --pool->mBusy;
+        if (pool->mBusy == 0) SDL_CondSignal(pool->mDone);
+        SDL_UnlockMutex(pool->mLock);
+    }
+    return 0;
+}
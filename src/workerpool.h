@@ -0,0 +1,41 @@
+#ifndef WORKERPOOL_H
+#define WORKERPOOL_H
+
+#include <functional>
+#include <vector>
+
+#include <SDL2/SDL.h>
+
+const int maxWorkerThreads = 16;
+
+typedef std::function<void(int)> WorkerJob;
+
+// A set of long lived threads for splitting up short, independent batches of
+// work. run calls job(0) through job(count - 1) spread across the workers and
+// the calling thread, and returns once all of them have finished. Jobs must
+// not depend on the order they're run in or on which thread runs them.
+class WorkerPool {
+public:
+    WorkerPool(int threadCount);
+    ~WorkerPool();
+
+    void run(int count, const WorkerJob &job);
+    int threadCount() const;
+
+private:
+    static int workerMain(void *data);
+    void work();
+
+    std::vector<SDL_Thread*> mThreads;
+    SDL_mutex *mLock;
+    SDL_cond *mWake;
+    SDL_cond *mDone;
+    const WorkerJob *mJob;
+    int mJobCount;
+    unsigned mBatch;
+    int mBusy;
+    bool mQuit;
+    SDL_atomic_t mNextJob;
+};
+
+#endif